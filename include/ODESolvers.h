@@ -9,18 +9,46 @@
 
 typedef unsigned long long int largeInt;
 
+struct _errorNorm;
+struct _radauWork;
+struct _esdirkWork;
+struct _rosenbrockWork;
+struct _sparsityPattern;
+struct _taylorTape;
+struct _expWork;
+struct _multirateWork;
+struct _ddeHistory;
+struct _brownianPath;
+
 typedef struct _solution {
     gsl_vector *dom;
     gsl_matrix *func;
 } solution;
 
+typedef struct _odeStats {
+    largeInt accepted, rejected; // adaptive steps
+    largeInt rhsCalls; // derivative evaluations of the adaptive steppers
+    largeInt rhsSaved; // derivative evaluations avoided by reusing the first stage
+    largeInt jacobians, decompositions; // implicit methods
+    largeInt fastCalls; // derivative evaluations of the fast group alone, multirate substeps with setMultirateModel()
+    largeInt fastAccepted, fastRejected; // multirate substeps of the fast group
+    largeInt diffusionCalls; // diffusion evaluations of the stochastic methods
+    largeInt krylovIterations, preconditionerSetups; // Newton-Krylov: GMRES iterations, each one derivative evaluation
+    largeInt refinements; // residual corrections of the mixed precision solves
+} odeStats;
+
 typedef struct _odeOptions {
     double step;
     largeInt GRIDPOINTS;
     largeInt lastIndex;
     double outInterval; // in terms of steps
     double relErr; // error tolerance
+    double *relTol; // per-component relative tolerance, defaults to relErr
+    double *absTol; // per-component absolute tolerance, NULL keeps the |y| + |h * dydt| scaling
+    int normType; // error norm of the adaptive steppers, 0: weighted RMS, 1: max
     bool adaptive; // adaptive algorithm switch
+    bool denseOutput; // interpolate adaptive solution onto the output grid
+    int order; // order of the embedded error estimate, sets the stepsize control exponents
     int NSYS;
     int printResult;
     int plotTimeSeries;
@@ -29,6 +57,54 @@ typedef struct _odeOptions {
     char *method;
     char *outputFilePath;
     int (*events)(const double *t, const double y[]);
+    double tPrevious, tCurrent; // last accepted adaptive step, covered by cont
+    double *yCurrent; // adaptive solution at tCurrent
+    double *stages; // stage derivatives of the embedded pairs
+    int stageCount; // derivative evaluations per trial step, including a shared first stage
+    bool firstStageShared; // trial steps take f(t, y) from stages[0]
+    bool fsal; // trial steps end with f(t + h, ynew) in stages[fsalSlot] (first same as last)
+    int fsalSlot; // stages[fsalSlot] holds f(t + h, ynew) after an accepted step
+    int denseStageCount; // extra derivative evaluations of the dense output
+    bool firstStageValid; // stages[0] already holds f(t, y) at the start of the next step
+    odeStats stats;
+    double *cont; // continuous extension coefficients for dense output
+    int extrapolationRow; // target row of the Bulirsch-Stoer extrapolation table
+    int threads; // threads computing the rows of the extrapolation table
+    double spectralRadius; // RKC: spectral radius of the Jacobian, from the input file or estimated
+    bool spectralRadiusFixed; // spectralRadius given in the input file
+    int spectralRadiusAge; // RKC steps since the last estimate
+    double *spectralVector; // dominant direction of the last power iteration
+    struct _radauWork *radau; // Radau IIA Jacobian, iteration matrices and Newton state
+    struct _esdirkWork *esdirk; // ESDIRK tableau, Jacobian and Newton matrix
+    int krylovSize; // GMRES iterations per restart of the Newton-Krylov ESDIRK methods, 0 for the dense LU
+    struct _rosenbrockWork *rosenbrock; // banded Jacobian and LU of the Rosenbrock method
+    int bandLower, bandUpper; // subdiagonals and superdiagonals of the Jacobian, -1 when not given
+    bool mixedPrecision; // Rosenbrock LU in single precision, refined against double residuals
+    bool sparsityDetection; // finite difference Jacobians on the detected sparsity pattern of the model
+    struct _sparsityPattern *sparsity; // pattern and column colours, NULL without sparsity detection
+    bool sensitivities; // state extended by its sensitivities to the parameters of setSensitivityParameters()
+    double *linearOperator; // linear part of the model for ETD-RK4, NULL without linearOperator
+    bool linearDiagonal; // linearOperator holds NSYS diagonal entries, else NSYS x NSYS row-major
+    double *massMatrix; // M of M y' = f(t, y) for Radau IIA, NULL for the identity
+    bool massDiagonal; // massMatrix holds NSYS diagonal entries, else NSYS x NSYS row-major
+    double *linearForcing; // pieces of the constant forcing b of a linear system, start time then NSYS entries
+    int forcingPieces;
+    struct _expWork *exponential; // phi functions of ETD-RK4, Jacobian of the exponential Rosenbrock method
+    int *fastComponents; // fast group of the multirate method, NULL without fastComponents
+    int fastCount;
+    int multirateRatio; // first macro step over the first fast substep
+    int splittingOrder; // 1: Lie, 2: Strang splitting of the registered operators
+    struct _multirateWork *multirate; // partition, substep ratio and slow interpolant of the multirate method
+    double *delays; // constant delays of the delay model, NULL without delays
+    int delayCount;
+    double maxDelay; // longest delay, bounds the stored history
+    struct _ddeHistory *delay; // history of the delay model registered by setDelayModel(), NULL otherwise
+    bool sdeAdaptive; // SRA1 and SRIW1 control their steps within the output intervals
+    int sdeLevel; // stochastic steps cut the output interval into 2^sdeLevel
+    unsigned int seed; // key of the Brownian paths
+    int ensembleSize; // Monte Carlo paths, 1 for a single path
+    struct _brownianPath *brownian; // Brownian tree of the single path of the stochastic methods, NULL otherwise
+    struct _taylorTape *taylor; // right hand side recorded for Taylor mode differentiation, NULL without taylorModel
     double domain[2];
     double yInitCond[];
 } odeOptions;
@@ -43,9 +119,17 @@ void ODEinit(odeOptions *, int (*)(const double *, const double []));
 
 solution * ODESolver(void (*)(const double *, const double [], double []), odeOptions *);
 int adaptiveODEIntegrate(void (*)(const double *, const double [], double []), solution *, odeOptions *, largeInt);
+int denseODEIntegrate(void (*)(const double *, const double [], double []), solution *, odeOptions *, largeInt, double);
+void adaptiveStep(void (*)(const double *, const double [], double []), double *, double [], double *, odeOptions *);
+void chebyshevSetup(void (*)(const double *, const double [], double []), double *, double [], double *, odeOptions *);
+double extrapolationStep(void (*)(const double *, const double [], double []), double *, double [], double [], double *, const struct _errorNorm *, odeOptions *);
 void ODEIntegrate(void (*)(const double *, const double [], double []), solution *, odeOptions *, largeInt, double);
 
 void genericSolver(void (*)(const double *, const double [], double []), double *, double *, double, odeOptions *);
+double adaptiveSolver(void (*)(const double *, const double [], double []), double *, double *, double *, double, const struct _errorNorm *, odeOptions *);
+void denseSolver(void (*)(const double *, const double [], double []), const double *, const double *, const double *, double, odeOptions *);
+void denseInterpolate(double, double *, odeOptions *);
+double interpolantResidual(void (*)(const double *, const double [], double []), int, const double [], double, double, const struct _errorNorm *, int);
 void realloc_gsl_containers(solution *, odeOptions *);
 
 #endif // ODE_SOLVERS_H
@@ -1,6 +1,20 @@
 #ifndef ALGORITHMS_H
 #define ALGORITHMS_H
 
+// -- Error Norms -----------------------------------------------------------
+
+#define ERRORNORM_RMS 0
+#define ERRORNORM_MAX 1
+
+// The adaptive steppers return the norm of err[i]/w[i] with the component weights
+// w[i] = absWeight[i] + relWeight[i] * max(|y[i]|, |ynew[i]|), computed in the same
+// sweep that forms the new solution. Pass NULL to skip the error estimate.
+typedef struct _errorNorm {
+    const double *absWeight;
+    const double *relWeight;
+    int type; // ERRORNORM_RMS or ERRORNORM_MAX
+} errorNorm;
+
 // -- nth Order Systems, Non-Adaptive ----------------------------------------------------
 
 void FWEuler(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double step, int NSYS);
@@ -14,7 +28,39 @@ void RK5Butcher(void (*derivative)(const double *t, const double y[], double ydo
 
 // -- nth Order Systems, Adaptive ----------------------------------------------------
 
-void CashKarp_RKF45(void (*)(const double *, const double [], double []), double *, double [], double [], double, double [], int);
+double CashKarp_RKF45(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+double Verner65(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+double DOP853(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+double BogackiShampine32(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+double Fehlberg45(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+double HeunEuler21(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int);
+// most stages of a RKC step, stability interval about 0.65 * RKC_MAXSTAGES^2
+#define RKC_MAXSTAGES 250
+
+double RKC(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, double [], int, int);
+int RKC_stages(double, double);
+double spectralRadius(void (*)(const double *, const double [], double []), const double *, const double [], const double [], double [], int *, int);
+double Richardson(void (*)(void (*)(const double *, const double [], double []), double *, double [], double, int), int, void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, int);
+
+// -- Extrapolation ----------------------------------------------------------
+
+// rows of the Gragg-Bulirsch-Stoer table and their substep sequence 2, 4, 6, ...
+#define GBS_MAXROWS 9
+#define GBS_SUBSTEPS(row) (2 * ((row) + 1))
+
+void ModifiedMidpoint(void (*)(const double *, const double [], double []), const double *, const double [], const double [], double, int, double [], int);
+void GBS_rows(void (*)(const double *, const double [], double []), const double *, const double [], const double [], double, int, int, double [], int, int);
+double GBS_extrapolate(int, double [], const double [], double [], const errorNorm *, int);
+
+// -- Dense Output ----------------------------------------------------------
+
+void Hermite_contd(const double [], const double [], const double [], const double [], double, double [], int);
+void Verner65_contd(const double [], double, double [], double [], int);
+void DOP853_contd(void (*)(const double *, const double [], double []), const double *, const double [], const double [], double, double [], double [], int);
+void polynomial_dense(double, const double [], int, double [], int);
+void polynomial_slope(double, const double [], int, double [], int);
+void DOP853_dense(double, const double [], double [], int);
+void DOP853_slope(double, const double [], double [], int);
 
 // -- Root Finder ----------------------------------------------------------//
 double newton_raphson(double (*)(double), double (*)(double), double, int);
@@ -0,0 +1,43 @@
+#ifndef BANDED_H
+#define BANDED_H
+
+#include <gsl/gsl_matrix.h>
+
+// -- Band Matrices -------------------------------------------------------------
+
+// An n x n matrix with `lower` subdiagonals and `upper` superdiagonals, stored by rows:
+// each row holds the width = lower + upper + 1 entries from column row - lower on. A
+// matrix to be LU decomposed needs lower extra superdiagonals for the fill-in of the
+// row interchanges.
+typedef struct _bandMatrix {
+    int n;
+    int lower, upper;
+    int width;
+    double *data; // n * width
+} bandMatrix;
+
+// single precision band, same layout, for the LU of mixed precision solves
+typedef struct _bandMatrixFloat {
+    int n;
+    int lower, upper;
+    int width;
+    float *data;
+} bandMatrixFloat;
+
+// entry (row, col) of either precision, |col - row| within the band
+#define BAND(A, row, col) ((A) -> data[(long) (row) * (A) -> width + (col) - (row) + (A) -> lower])
+
+bandMatrix * bandAlloc(int, int, int);
+void bandFree(bandMatrix *);
+void bandZero(bandMatrix *);
+void bandAdd(bandMatrix *, int, int, double);
+void bandMultiply(const bandMatrix *, const double [], double []);
+void bandToDense(const bandMatrix *, gsl_matrix *);
+int bandLU(bandMatrix *, int []);
+void bandSolve(const bandMatrix *, const int [], double []);
+bandMatrixFloat * bandAllocFloat(int, int, int);
+void bandFreeFloat(bandMatrixFloat *);
+int bandLUFloat(bandMatrixFloat *, int []);
+void bandSolveFloat(const bandMatrixFloat *, const int [], float []);
+
+#endif // BANDED_H
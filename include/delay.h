@@ -0,0 +1,54 @@
+#ifndef DELAY_H
+#define DELAY_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+// -- History -------------------------------------------------------------------
+
+// highest order of the derivative jumps followed from t0, and first ring buffer size
+#define DDE_MAXLEVEL 8
+#define DDE_SEGMENTS 64
+
+// A derivative jump at t of the given level: level 0 is t0, and a lag reaching a jump of
+// level k makes one of level k + 1.
+typedef struct _ddeBreakpoint {
+    double t;
+    int level;
+} ddeBreakpoint;
+
+// Solution of a delay differential equation y'(t) = f(t, y(t), y(t - tau_1), ...) over
+// the last maxDelay: the continuous extensions of the accepted steps in a ring buffer,
+// oldest at head. Segments older than t - maxDelay are dropped, so its size follows the
+// number of steps within one maximum delay and not the domain.
+typedef struct _ddeHistory {
+    int NSYS;
+    int methodId; // selects the continuous extension, as in denseInterpolate()
+    int contSize; // entries of a continuous extension
+    int contOrder; // its order, sets the stepsize from the residual
+    int delayCount;
+    const double *delays; // constant delays, NULL for state-dependent ones
+    double maxDelay;
+    double t0;
+    double *y0;
+    int capacity, head, count;
+    double *tStart, *step; // capacity entries
+    double *cont; // contSize per segment
+    ddeBreakpoint *breakpoints; // sorted by t
+    int breakpointCount, breakpointCapacity, maxLevel;
+} ddeHistory;
+
+// -- Delay Differential Equations ----------------------------------------------
+
+void setDelayModel(void (*)(const double *, const double [], const double [], double []), int, void (*)(const double *, const double [], double []), void (*)(const double *, double []));
+bool hasDelayModel(void);
+int delayModelCount(void);
+bool delayModelConstant(void);
+ddeHistory * ddeAlloc(odeOptions *);
+void ddeFree(ddeHistory *);
+void ddeLag(const ddeHistory *, double, double []);
+void ddeDerivative(const double *, const double [], double []);
+double ddeLimitStep(ddeHistory *, double, const double [], double);
+double ddeRecord(ddeHistory *, void (*)(const double *, const double [], double []), const errorNorm *, double, const double [], const double [], double, const double []);
+
+#endif // DELAY_H
@@ -0,0 +1,54 @@
+#ifndef EXPONENTIAL_H
+#define EXPONENTIAL_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+#include <stdbool.h>
+#include <gsl/gsl_matrix.h>
+
+// -- Workspaces ----------------------------------------------------------------
+
+// stepsizes whose phi functions ETD-RK4 keeps: the step, its half for Richardson step
+// doubling and the shortened steps at the end of an output interval
+#define EXP_CACHESIZE 4
+
+// phi functions of one stepsize h for ETD-RK4, in the order e^(hL/2), phi1(hL/2), e^(hL),
+// phi1(hL), phi2(hL), phi3(hL): NSYS entries each for a diagonal L, NSYS x NSYS row-major
+// matrices for a dense one
+typedef struct _phiCache {
+    double h; // 0 marks an empty entry
+    long lastUse;
+    double *phi;
+} phiCache;
+
+// State of the exponential integrators: the linear part L of y' = L y + N(t, y) with the
+// phi functions of the last stepsizes (ETD-RK4), and the Jacobian of the step start of the
+// exponential Rosenbrock method, augmented by df/dt as the system is made autonomous.
+typedef struct _expWork {
+    int NSYS;
+    bool diagonal; // L given by its diagonal
+    bool linear; // cache holds e^(hL) and phi1(hL) only, for linear systems
+    double *L; // NSYS entries or NSYS x NSYS row-major, NULL for the Rosenbrock method
+    phiCache cache[EXP_CACHESIZE];
+    long uses;
+    gsl_matrix *jac; // (NSYS + 1) x (NSYS + 1), last column df/dt, last row zero
+    double jacTime; // t of the Jacobian
+    bool jacValid;
+} expWork;
+
+// -- Matrix Functions ----------------------------------------------------------
+
+void expm(const gsl_matrix *, gsl_matrix *);
+void phiMatrices(const gsl_matrix *, int, gsl_matrix *[]);
+void phiScalars(double, int, double []);
+
+// -- Exponential Integrators ---------------------------------------------------
+
+expWork * expAlloc(int, const double *, bool, bool);
+void expFree(expWork *);
+void ETDRK4(void (*)(const double *, const double [], double []), double *, double [], double, int);
+void LinearExpm(void (*)(const double *, const double [], double []), double *, double [], double, odeOptions *);
+double ExpRosenbrock43(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, odeOptions *);
+
+#endif // EXPONENTIAL_H
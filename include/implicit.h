@@ -0,0 +1,149 @@
+#ifndef IMPLICIT_H
+#define IMPLICIT_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+#include "banded.h"
+
+#include <stdbool.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_permutation.h>
+
+// -- Workspaces ----------------------------------------------------------------
+
+// State of the Radau IIA integrator carried from step to step: the Jacobian, the
+// real and complex iteration matrices and the collocation polynomial of the last
+// accepted step (kept in options -> cont, also used for the Newton starting values).
+// With a mass matrix it solves M y' = f(t, y), where zero rows of M are algebraic
+// equations of an index-1 DAE.
+typedef struct _radauWork {
+    gsl_matrix *jac; // df/dy, NSYS x NSYS
+    gsl_matrix *E1; // real iteration matrix (gamma/h) M - J, LU decomposed
+    gsl_matrix_complex *E2; // complex iteration matrix ((alpha + i beta)/h) M - J, LU decomposed
+    const double *mass; // M of M y' = f(t, y), NULL for the identity
+    bool massDiagonal; // mass holds NSYS diagonal entries, else NSYS x NSYS row-major
+    gsl_permutation *p1, *p2;
+    double *z; // stage increments z1, z2, z3 (3 * NSYS)
+    double *f; // transformed stage increments (3 * NSYS)
+    double *scal; // error weights at the start of the step
+    double hLU; // stepsize of the current iteration matrices
+    double hOld; // stepsize of the last accepted step
+    double theta; // Newton contraction rate of the last step
+    double faccon;
+    double hAcc, errAcc; // last accepted step and error, predictive stepsize control
+    bool first; // no step accepted yet
+    bool reject; // last trial rejected
+    bool jacValid; // jac may be reused for the next step
+    bool jacFresh; // jac evaluated at the current (t, y)
+    bool luValid;
+} radauWork;
+
+// Butcher tableau of an ESDIRK method: explicit first stage, then implicit stages that
+// share the diagonal coefficient gamma. A is row-major stages x stages, b advances the
+// solution and bhat is the embedded solution of the error estimate. Additive (IMEX)
+// methods add the explicit tableau Ae for the non-stiff part, NULL otherwise.
+typedef struct _esdirkTableau {
+    int stages;
+    double gamma;
+    const double *c, *A, *b, *bhat;
+    const double *Ae;
+} esdirkTableau;
+
+// State of the ESDIRK integrators: one Newton matrix I - h gamma J serves every stage
+// of a step and is kept across steps while the stepsize and Jacobian do not change.
+// With a Krylov subspace size the Newton corrections come from GMRES on finite
+// difference products J v instead, and no NSYS x NSYS matrix is stored.
+typedef struct _esdirkWork {
+    const esdirkTableau *tableau;
+    gsl_matrix *jac; // df/dy, NSYS x NSYS, NULL for Newton-Krylov
+    gsl_matrix *M; // I - h gamma J, LU decomposed, NULL for Newton-Krylov
+    gsl_permutation *perm;
+    int krylovSize; // GMRES iterations per restart, 0 for the dense LU
+    double *krylov; // Arnoldi basis and work vectors ((krylovSize + 3) * NSYS)
+    double hLU; // stepsize of the current Newton matrix or preconditioner
+    int jacAge; // trial steps since the Jacobian was evaluated
+    bool jacValid, luValid;
+} esdirkWork;
+
+extern const esdirkTableau TRBDF2_tableau, ESDIRK43_tableau, ARK43_tableau;
+
+// stages of the Rosenbrock method
+#define ROS_STAGES 4
+
+// most refinement sweeps of a mixed precision solve
+#define ROS_REFINEMENTS 4
+
+// State of the linearly implicit Rosenbrock stepper on banded Jacobians: the band of
+// df/dy and df/dt, and the banded LU of I/(h gamma) - J kept while the stepsize and the
+// Jacobian do not change. The method is a W-method, so the Jacobian is carried across
+// steps and refreshed by age or after a rejected trial. In mixed precision the LU is
+// kept in single precision and the solves are refined against residuals of the double
+// precision Jacobian.
+typedef struct _rosenbrockWork {
+    bandMatrix *jac; // df/dy with the bandwidths of the model
+    bandMatrix *M; // I/(h gamma) - J, LU decomposed, lower extra superdiagonals for the pivoting, NULL in mixed precision
+    bandMatrixFloat *Mf; // single precision LU of I/(h gamma) - J in mixed precision, NULL otherwise
+    float *rf; // single precision right hand side
+    double *b, *residual; // right hand side and residual of the refinement
+    double luScale; // Mf holds luScale (I/(h gamma) - J), near unit size
+    bool mixed;
+    int *pivot;
+    double *ft; // df/dt
+    double *U; // stage increments (ROS_STAGES * NSYS)
+    double a[ROS_STAGES * ROS_STAGES], c[ROS_STAGES * ROS_STAGES]; // stage couplings of the transformed method
+    double m[ROS_STAGES], e[ROS_STAGES]; // solution weights and their difference to the embedded ones
+    double alpha[ROS_STAGES], gammaSum[ROS_STAGES]; // stage times, df/dt weights
+    double hLU; // stepsize of the current LU
+    double jacTime; // time of the Jacobian
+    double tTrial; // start of the last trial step
+    int jacAge; // trial steps since the Jacobian was evaluated
+    bool jacValid, luValid;
+} rosenbrockWork;
+
+// -- Jacobian ------------------------------------------------------------------
+
+int jacobianFD(void (*)(const double *, const double [], double []), const double *, const double [], const double [], gsl_matrix *, int);
+int jacobianBandFD(void (*)(const double *, const double [], double []), const double *, const double [], const double [], bandMatrix *);
+
+// -- Radau IIA -----------------------------------------------------------------
+
+radauWork * radauAlloc(int, const double *, bool);
+void radauFree(radauWork *);
+double RadauIIA5(void (*)(const double *, const double [], double []), double *, double [], double [], double *, const errorNorm *, odeOptions *);
+void Radau_dense(double, const double [], double [], int);
+void Radau_slope(double, const double [], double [], int);
+
+// -- Differential-Algebraic Equations ------------------------------------------
+
+// most Newton iterations of the consistent initialization
+#define DAE_MAXNEWTON 20
+
+void daeInitialize(void (*)(const double *, const double [], double []), odeOptions *);
+
+// -- ESDIRK --------------------------------------------------------------------
+
+esdirkWork * esdirkAlloc(const esdirkTableau *, int, int);
+void esdirkFree(esdirkWork *);
+double ESDIRK(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, odeOptions *);
+
+// -- Newton-Krylov --------------------------------------------------------------
+
+// restarts of GMRES after the first krylovSize iterations
+#define KRYLOV_RESTARTS 2
+
+void setPreconditioner(void (*)(const double *, const double [], double), void (*)(const double [], double []));
+bool hasPreconditioner(void);
+
+// -- Rosenbrock ----------------------------------------------------------------
+
+rosenbrockWork * rosenbrockAlloc(int, int, int, bool);
+void rosenbrockFree(rosenbrockWork *);
+double ROS34PW2(void (*)(const double *, const double [], double []), double *, double [], double [], double, const errorNorm *, odeOptions *);
+
+// -- IMEX Additive Runge-Kutta -------------------------------------------------
+
+void setIMEXModel(void (*)(const double *, const double [], double []), void (*)(const double *, const double [], double []), int);
+bool hasIMEXModel(void);
+void imexDerivative(const double *, const double [], double []);
+
+#endif // IMPLICIT_H
@@ -0,0 +1,55 @@
+#ifndef MOL_H
+#define MOL_H
+
+#include "ODESolvers.h"
+#include "banded.h"
+
+// -- Grid ----------------------------------------------------------------------
+
+// most components per grid node
+#define MOL_MAXCOMP 16
+
+// nodes per column block of the stencil sweep, sized so that three rows of a block
+// stay in cache
+#define MOL_BLOCK 512
+
+// boundary conditions
+#define MOL_DIRICHLET 0 // u = value on the boundary
+#define MOL_NEUMANN 1 // outward normal derivative du/dn = value
+#define MOL_PERIODIC 2 // both sides of the direction
+
+// sides of the grid
+#define MOL_WEST 0
+#define MOL_EAST 1
+#define MOL_SOUTH 2
+#define MOL_NORTH 3
+
+// Cell-centred grid of nx x ny cells on [xa, xb] x [ya, yb] (ny = 1 in 1D) for
+//     du_c/dt = D_c lap(u_c) - vx_c du_c/dx - vy_c du_c/dy + R_c(t, x, u)
+// with ncomp components per node, interleaved: u_c at node (i, j) is
+// y[(j * nx + i) * ncomp + c]. Second order central differences; the boundary
+// conditions set a ghost value outside each boundary cell.
+typedef struct _molGrid {
+    int dims; // 1 or 2
+    int nx, ny;
+    int ncomp;
+    double xa, xb, ya, yb;
+    double diffusion[MOL_MAXCOMP];
+    double velocity[2][MOL_MAXCOMP];
+    int bc[4]; // by side
+    double bcValue[4][MOL_MAXCOMP]; // Dirichlet value or normal derivative by side and component
+} molGrid;
+
+// -- Method of Lines -----------------------------------------------------------
+
+void setMOLModel(const molGrid *, void (*)(const double *, const double [], const double [], double []), void (*)(const double [], double []));
+bool hasMOLModel(void);
+int molSize(void);
+void molBandwidth(int *, int *);
+void molNode(int, double []);
+void molInitial(double []);
+void molDerivative(const double *, const double [], double []);
+int molJacobian(const double *, const double [], bandMatrix *);
+int molJacobianDense(const double *, const double [], gsl_matrix *);
+
+#endif // MOL_H
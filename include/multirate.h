@@ -0,0 +1,30 @@
+#ifndef MULTIRATE_H
+#define MULTIRATE_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+// -- Workspace -----------------------------------------------------------------
+
+// State of the multirate stepper: the partition into fast and slow components, the
+// substep of the fast group and the cubic Hermite interpolant of the macro step that
+// supplies the slow components to the fast substeps.
+typedef struct _multirateWork {
+    int NSYS;
+    int fastCount;
+    int *fast; // indices of the fast components
+    int ratio; // macro step over the first fast substep
+    double hFast; // next substep of the fast group, 0 before the first macro step
+    double tMacro, hMacro; // macro step covered by cont
+    double *cont; // Hermite interpolant of the macro step, 4 * NSYS
+    void (*derivative)(const double *t, const double y[], double ydot[]);
+} multirateWork;
+
+// -- Multirate -----------------------------------------------------------------
+
+multirateWork * multirateAlloc(int, const int [], int, int);
+void multirateFree(multirateWork *);
+void setMultirateModel(void (*)(const double *, const double [], double []));
+double MultirateStep(void (*)(const double *, const double [], double []), double *, double [], double [], double *, const errorNorm *, odeOptions *);
+
+#endif // MULTIRATE_H
@@ -0,0 +1,22 @@
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include "ODESolvers.h"
+
+// -- Forward Sensitivities -----------------------------------------------------
+
+// most parameters of a sensitivity run
+#define SENS_MAXPARAMS 32
+
+// The sensitivities s_j = dy/dp_j of the state to the registered parameters follow
+//     s_j' = J s_j + df/dp_j,    s_j(t0) = 0
+// and are integrated with the state as one system of NSYS (1 + P) unknowns, y first and
+// then s_1 .. s_P, NSYS each: the steppers take the same steps and control the error of
+// all of them (the simultaneous corrector of CVODES for the implicit methods).
+
+void setSensitivityParameters(double *[], const char *[], int);
+int sensitivityCount(void);
+odeOptions * sensitivityInit(odeOptions *, void (*)(const double *, const double [], double []));
+void sensitivityDerivative(const double *, const double [], double []);
+
+#endif // SENSITIVITY_H
@@ -0,0 +1,34 @@
+#ifndef SPARSITY_H
+#define SPARSITY_H
+
+#include "ODESolvers.h"
+
+// -- Sparsity Pattern ----------------------------------------------------------
+
+// random base points probed per column of the detection, so an entry that vanishes at
+// one point by coincidence is seen at another
+#define SPARSITY_PROBES 2
+
+// Nonzero pattern of df/dy by columns, and a colouring of the columns in which no two
+// columns of a colour share a row: one derivative evaluation perturbing all columns of
+// a colour gives all their entries, so a finite difference Jacobian costs `colors`
+// evaluations instead of NSYS.
+typedef struct _sparsityPattern {
+    int NSYS;
+    int nonzeros;
+    int *colStart; // rows of column j at rows[colStart[j]] .. rows[colStart[j + 1] - 1] (NSYS + 1)
+    int *rows;
+    int colors;
+    int *colorStart; // columns of colour c at columns[colorStart[c]] .. (colors + 1)
+    int *columns;
+    int lower, upper; // bandwidths spanned by the pattern
+} sparsityPattern;
+
+// -- Detection -----------------------------------------------------------------
+
+sparsityPattern * sparsityInit(void (*)(const double *, const double [], double []), odeOptions *);
+void sparsityFree(sparsityPattern *);
+void setSparsity(sparsityPattern *);
+sparsityPattern * getSparsity(void);
+
+#endif // SPARSITY_H
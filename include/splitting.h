@@ -0,0 +1,35 @@
+#ifndef SPLITTING_H
+#define SPLITTING_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+// -- Operators -----------------------------------------------------------------
+
+// most operators of a split model
+#define SPLIT_MAXOPERATORS 8
+
+// One piece of a split model y' = f_1(t, y) + ... + f_n(t, y). It is advanced either by
+// its exact flow, or by `substeps` steps of the fixed stepsize method methodId (1-8) on
+// its right hand side. An operator with every = k runs once per k splitting steps, over
+// the time they covered.
+typedef struct _splitOperator {
+    void (*derivative)(const double *t, const double y[], double ydot[]); // NULL with a flow
+    void (*flow)(const double *t, double y[], double step); // exact solution over step, NULL otherwise
+    int methodId;
+    int substeps;
+    int every;
+    int pending; // splitting steps since the last run
+    double tStart, elapsed; // time not yet covered by the operator
+} splitOperator;
+
+// -- Splitting -----------------------------------------------------------------
+
+void addSplitOperator(void (*)(const double *, const double [], double []), int, int, int);
+void addSplitFlow(void (*)(const double *, double [], double), int);
+void clearSplitOperators(void);
+int splitOperatorCount(void);
+void splitReset(void);
+void SplitStep(double *, double [], double, odeOptions *);
+
+#endif // SPLITTING_H
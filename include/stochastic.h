@@ -0,0 +1,47 @@
+#ifndef STOCHASTIC_H
+#define STOCHASTIC_H
+
+#include <stdint.h>
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+// -- Random Numbers ------------------------------------------------------------
+
+// Philox4x32-10 counter-based generator (Salmon et al., SC'11): four 32 bit words of
+// output per counter, stateless, so any draw can be recomputed from its counter and key
+void philox4x32(const uint32_t [4], const uint32_t [2], uint32_t [4]);
+
+// -- Brownian Path -------------------------------------------------------------
+
+// deepest level of the Brownian tree, steps down to 2^-40 of the output interval
+#define SDE_MAXDEPTH 40
+
+// One path of a Wiener process over an output interval, as a binary tree of Brownian
+// bridges: node n (root 1, children 2n and 2n + 1) carries the increment W and the
+// space-time Levy area H = Z / h - W / 2 of its subinterval, Z the integral of W over
+// it. The children of a node follow from its own draws, so every subinterval has the
+// same increments whichever steps reached it, and a rejected step retried shorter
+// stays on the path. The last path from the root is cached, with its node ids.
+typedef struct _brownianPath {
+    int NSYS;
+    uint32_t seed, member;
+    largeInt interval; // output interval index, part of the counter
+    double length;
+    int depth; // deepest cached node
+    largeInt node[SDE_MAXDEPTH + 1];
+    double *W, *H; // NSYS per depth
+} brownianPath;
+
+// -- Stochastic Differential Equations -----------------------------------------
+
+void setDiffusion(void (*)(const double *, const double [], double []));
+bool hasDiffusion(void);
+bool diffusionAdditive(double, const double [], int);
+brownianPath * brownianAlloc(int, uint32_t);
+void brownianFree(brownianPath *);
+void brownianReset(brownianPath *, uint32_t, largeInt, double);
+void brownianIncrement(brownianPath *, int, largeInt, double [], double []);
+void SDEStep(void (*)(const double *, const double [], double []), double *, double [], double, odeOptions *);
+largeInt sdeEnsemble(void (*)(const double *, const double [], double []), solution *, odeOptions *);
+
+#endif // STOCHASTIC_H
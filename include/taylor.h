@@ -0,0 +1,64 @@
+#ifndef TAYLOR_H
+#define TAYLOR_H
+
+#include "ODESolvers.h"
+#include "algorithms.h"
+
+// -- Taylor Mode Automatic Differentiation -------------------------------------
+
+// highest order of the Taylor integrator
+#define TAYLOR_MAXORDER 30
+
+// operations of the tape, each node combines at most two earlier nodes
+enum taylorOp {
+    TAYLOR_CONST, TAYLOR_TIME, TAYLOR_VAR,
+    TAYLOR_ADD, TAYLOR_SUB, TAYLOR_MUL, TAYLOR_DIV, TAYLOR_NEG,
+    TAYLOR_EXP, TAYLOR_LOG, TAYLOR_SQRT, TAYLOR_POW, TAYLOR_SIN, TAYLOR_COS
+};
+
+// One node of the tape. a and b index earlier nodes; value is the constant of
+// TAYLOR_CONST, the component of TAYLOR_VAR and the exponent of TAYLOR_POW. TAYLOR_SIN
+// and TAYLOR_COS come in pairs whose b is the partner node.
+typedef struct _taylorNode {
+    enum taylorOp op;
+    int a, b;
+    double value;
+} taylorNode;
+
+// The right hand side as a list of operations. Nodes 0 .. NSYS - 1 are the components of
+// y and node NSYS is t; output[i] is the node of dy[i]/dt. coef holds the Taylor
+// coefficients of every node, (TAYLOR_MAXORDER + 1) per node, tangent the directional
+// derivatives of the forward mode sweep, as many per node as its last width.
+typedef struct _taylorTape {
+    taylorNode *nodes;
+    int nodeCount, capacity;
+    int NSYS;
+    int *output;
+    double *coef;
+    double *tangent;
+    long tangentSize; // doubles allocated in tangent
+} taylorTape;
+
+// -- Tape Construction ---------------------------------------------------------
+
+taylorTape * taylorTapeAlloc(int);
+void taylorTapeFree(taylorTape *);
+int taylorConstant(taylorTape *, double);
+int taylorVariable(taylorTape *, int);
+int taylorTime(taylorTape *);
+int taylorBinary(taylorTape *, enum taylorOp, int, int);
+int taylorUnary(taylorTape *, enum taylorOp, int);
+int taylorPower(taylorTape *, int, double);
+void taylorOutput(taylorTape *, int, int);
+taylorTape * taylorParse(const char *[], int, const char *[], const double [], int);
+void setTaylorModel(taylorTape *);
+taylorTape * getTaylorModel(void);
+
+// -- Evaluation ----------------------------------------------------------------
+
+void taylorCoefficients(taylorTape *, double, const double [], int, double []);
+void taylorDerivative(const double *, const double [], double []);
+void taylorTangents(taylorTape *, double, const double [], const double [], int, double [], double []);
+double TaylorStep(double *, double [], double [], double *, const errorNorm *, odeOptions *);
+
+#endif // TAYLOR_H
@@ -9,6 +9,7 @@
 
 void specifySolverMethodInit(odeOptions *);
 void printResult(solution *, odeOptions *);
+void printStats(odeOptions *);
 void writefile(solution *, odeOptions *);
 void plotData(solution *, odeOptions *);
 void delete(solution *, odeOptions *);
@@ -7,6 +7,16 @@
 
 #include "ODESolvers.h"
 #include "algorithms.h"
+#include "implicit.h"
+#include "taylor.h"
+#include "exponential.h"
+#include "multirate.h"
+#include "splitting.h"
+#include "delay.h"
+#include "stochastic.h"
+#include "mol.h"
+#include "sparsity.h"
+#include "sensitivity.h"
 #include "utilities.h"
 #include "parson.h"
 
@@ -16,6 +26,7 @@
 #include <string.h>
 
 #include <math.h>
+#include <float.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 
@@ -23,9 +34,61 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <assert.h>
+#include <pthread.h>
 
 // -- Caller Function ---------------------------------------------------------
 
+// vectors of NSYS doubles the steppers keep on the stack along the deepest calls, and
+// the stack of the main thread assumed to fit them for small systems
+#define SOLVER_STACKVECTORS 64
+#define SOLVER_STACK (8u << 20)
+
+typedef struct _solverCall {
+    void (*derivative)(const double *t, const double y[], double ydot[]);
+    odeOptions *options;
+    solution *result;
+} solverCall;
+
+static void * solverRun(void *arg){
+
+    solverCall *call = (solverCall *) arg;
+    call -> result = ODESolver(call -> derivative, call -> options);
+
+    return NULL;
+}
+
+// The steppers keep their vectors on the stack as variable length arrays. Large systems,
+// such as method-of-lines models, are solved on a thread with a stack to fit them.
+static solution * solverThread(void (*derivative)(const double *t, const double y[], double ydot[]), odeOptions *options){
+
+    size_t stack = (size_t) SOLVER_STACKVECTORS * options -> NSYS * sizeof(double);
+    solverCall call = { .derivative = derivative, .options = options, .result = NULL };
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if(stack <= SOLVER_STACK) {
+        return ODESolver(derivative, options);
+    }
+
+    pthread_attr_init(&attr);
+    if(pthread_attr_setstacksize(&attr, stack + SOLVER_STACK) == 0 && pthread_create(&thread, &attr, solverRun, &call) == 0) {
+        pthread_join(thread, NULL);
+    } else {
+        solverRun(&call);
+    }
+    pthread_attr_destroy(&attr);
+
+    return call.result;
+}
+
+// banded Rosenbrock work on the bandwidths of the options, at most NSYS - 1
+static void rosenbrockInit(odeOptions *options){
+
+    options -> bandLower = (options -> bandLower < options -> NSYS - 1) ? options -> bandLower : options -> NSYS - 1;
+    options -> bandUpper = (options -> bandUpper < options -> NSYS - 1) ? options -> bandUpper : options -> NSYS - 1;
+    options -> rosenbrock = rosenbrockAlloc(options -> NSYS, options -> bandLower, options -> bandUpper, options -> mixedPrecision);
+}
+
 void callODESolver(void (*derivative)(const double *t, const double y[], double ydot[]), int (*events)(const double *, const double []), const char *inputfile, int NSYS){
 
     puts("\n---------------------- Starting the program! ----------------------\n");
@@ -34,9 +97,60 @@ void callODESolver(void (*derivative)(const double *t, const double y[], double
 
     odeOptions *options = readInput(inputfile, NSYS);
 
+    // the sensitivities to the model parameters extend the state before the workspaces
+    // are sized
+    if(options -> sensitivities) {
+        options = sensitivityInit(options, derivative);
+    }
+
     ODEinit(options, events);
 
-    solution *result = ODESolver(derivative, options);
+    // a model split by setIMEXModel() runs as the sum of its parts outside the IMEX method
+    if(hasIMEXModel()) {
+        derivative = imexDerivative;
+    }
+
+    // a method-of-lines model registered by setMOLModel() is the right hand side
+    if(hasMOLModel()) {
+        printf("\t- Method-of-lines model with %d unknowns\n", molSize());
+        derivative = molDerivative;
+    }
+
+    // a delay model registered by setDelayModel() reads its lags from the stored history
+    if(hasDelayModel()) {
+        printf("\t- Delay model with %d %s delays\n", options -> delayCount, delayModelConstant() ? "constant" : "state-dependent");
+        derivative = ddeDerivative;
+    }
+
+    // a model given as expressions in the input file replaces the compiled derivative
+    if(options -> taylor != NULL) {
+        printf("\t- Derivatives from the taylorModel expressions\n");
+        derivative = taylorDerivative;
+    }
+
+    // the state and its sensitivities are stepped as one system
+    if(options -> sensitivities) {
+        derivative = sensitivityDerivative;
+    }
+
+    // the sparsity pattern of the right hand side compresses its finite difference
+    // Jacobians and gives the banded Rosenbrock method its bandwidths
+    if(options -> sparsityDetection) {
+        options -> sparsity = sparsityInit(derivative, options);
+        setSparsity(options -> sparsity);
+    }
+    if(options -> methodId == 30 && options -> rosenbrock == NULL) {
+        options -> bandLower = options -> sparsity -> lower;
+        options -> bandUpper = options -> sparsity -> upper;
+        rosenbrockInit(options);
+    }
+
+    // the algebraic components of a DAE start on their constraints
+    if(options -> massMatrix != NULL) {
+        daeInitialize(derivative, options);
+    }
+
+    solution *result = solverThread(derivative, options);
 
     // post-process data
 
@@ -44,6 +158,8 @@ void callODESolver(void (*derivative)(const double *t, const double y[], double
 
     printResult(result, options);
 
+    printStats(options);
+
     plotData(result, options);
 
     delete(result, options);
@@ -56,6 +172,65 @@ void callODESolver(void (*derivative)(const double *t, const double y[], double
 
 // -- Input Reader Function ---------------------------------------------------
 
+// tolerances are given either as one number for all components or as an array of NSYS numbers
+static double * readTolerance(JSON_Object *data, const char *key, double fallback, int NSYS){
+
+    double *tolerance = (double *) malloc(sizeof(double) * NSYS);
+    JSON_Array *buffer = json_object_get_array(data, key);
+
+    for (int var = 0; var < NSYS; ++var) {
+        if(buffer != NULL) {
+            tolerance[var] = json_array_get_number(buffer, var);
+        } else if(json_object_has_value_of_type(data, key, JSONNumber)) {
+            tolerance[var] = json_object_get_number(data, key);
+        } else {
+            tolerance[var] = fallback;
+        }
+    }
+
+    if(buffer != NULL && json_array_get_count(buffer) != (size_t) NSYS) {
+        fprintf(stderr, "%s needs %d entries, one per component. Exiting program..\n", key, NSYS);
+        exit(EXIT_FAILURE);
+    }
+
+    return tolerance;
+}
+
+// matrices are given either as NSYS numbers for a diagonal matrix or as NSYS rows of NSYS
+// numbers, stored row-major; NULL if the key is absent
+static double * readMatrix(JSON_Object *data, const char *key, bool *diagonal, int NSYS){
+
+    JSON_Array *buffer = json_object_get_array(data, key);
+
+    *diagonal = true;
+    if(buffer == NULL) {
+        return NULL;
+    }
+
+    *diagonal = (json_array_get_array(buffer, 0) == NULL);
+    double *matrix = (double *) malloc(sizeof(double) * (*diagonal ? NSYS : NSYS * NSYS));
+    if(json_array_get_count(buffer) != (size_t) NSYS) {
+        fprintf(stderr, "%s needs %d entries or rows. Exiting program..\n", key, NSYS);
+        exit(EXIT_FAILURE);
+    }
+    for (int row = 0; row < NSYS; ++row) {
+        JSON_Array *entries = json_array_get_array(buffer, row);
+        if(*diagonal) {
+            matrix[row] = json_array_get_number(buffer, row);
+            continue;
+        }
+        if(entries == NULL || json_array_get_count(entries) != (size_t) NSYS) {
+            fprintf(stderr, "%s rows need %d entries. Exiting program..\n", key, NSYS);
+            exit(EXIT_FAILURE);
+        }
+        for (int col = 0; col < NSYS; ++col) {
+            matrix[row * NSYS + col] = json_array_get_number(entries, col);
+        }
+    }
+
+    return matrix;
+}
+
 odeOptions * readInput(const char *inputjson, int NSYS){
 
     odeOptions *options = (odeOptions *) malloc(sizeof(odeOptions) + sizeof(long double) * NSYS);
@@ -71,9 +246,152 @@ odeOptions * readInput(const char *inputjson, int NSYS){
     options -> step = json_object_get_number(data, "stepsize");
     options -> outInterval = json_object_get_number(data, "outputInterval");
     options -> relErr = json_object_get_number(data, "relative_errorPC") / 100;
+    options -> relTol = readTolerance(data, "relTol", options -> relErr, NSYS);
+    options -> absTol = json_object_has_value(data, "absTol") ? readTolerance(data, "absTol", 0.0, NSYS) : NULL;
+    options -> normType = json_object_get_number(data, "errorNorm");
+
+    for (int var = 0; options -> absTol != NULL && var < NSYS; ++var) {
+        if(options -> absTol[var] <= 0.0) {
+            fprintf(stderr, "absTol entries must be positive. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
     options -> NSYS = NSYS;
     options -> adaptive = (bool) json_object_get_number(data, "adaptive_switch");
+    options -> denseOutput = (bool) json_object_get_number(data, "denseOutput");
     options -> methodId = json_object_get_number(data, "methodId");
+    options -> threads = json_object_has_value(data, "threads") ? json_object_get_number(data, "threads") : 1;
+    options -> spectralRadiusFixed = json_object_has_value(data, "spectralRadius");
+    options -> spectralRadius = json_object_get_number(data, "spectralRadius");
+
+    // linear part L of y' = L y + N(t, y) for ETD-RK4
+    options -> linearOperator = readMatrix(data, "linearOperator", &options -> linearDiagonal, NSYS);
+
+    // mass matrix M of M y' = f(t, y) for Radau IIA, singular for algebraic equations
+    options -> massMatrix = readMatrix(data, "massMatrix", &options -> massDiagonal, NSYS);
+
+    // forcing b of a linear system y' = A y + b: NSYS numbers for a constant b, or rows of a
+    // start time and NSYS numbers for a piecewise constant one, by increasing start time
+    options -> linearForcing = NULL; options -> forcingPieces = 0;
+    buffer = json_object_get_array(data, "linearForcing");
+    if(buffer != NULL) {
+        bool constant = (json_array_get_array(buffer, 0) == NULL);
+        options -> forcingPieces = constant ? 1 : json_array_get_count(buffer);
+        options -> linearForcing = (double *) malloc(sizeof(double) * options -> forcingPieces * (NSYS + 1));
+        if(constant && json_array_get_count(buffer) != (size_t) NSYS) {
+            fprintf(stderr, "linearForcing needs %d entries or rows of a start time and %d entries. Exiting program..\n", NSYS, NSYS);
+            exit(EXIT_FAILURE);
+        }
+        for (int piece = 0; piece < options -> forcingPieces; ++piece) {
+            double *row = &options -> linearForcing[piece * (NSYS + 1)];
+            JSON_Array *entries = json_array_get_array(buffer, piece);
+            if(constant) {
+                row[0] = -HUGE_VAL;
+                for (int var = 0; var < NSYS; ++var) {
+                    row[1 + var] = json_array_get_number(buffer, var);
+                }
+                continue;
+            }
+            if(entries == NULL || json_array_get_count(entries) != (size_t) NSYS + 1) {
+                fprintf(stderr, "linearForcing rows need a start time and %d entries. Exiting program..\n", NSYS);
+                exit(EXIT_FAILURE);
+            }
+            for (int col = 0; col <= NSYS; ++col) {
+                row[col] = json_array_get_number(entries, col);
+            }
+            if(piece > 0 && row[0] <= row[-(NSYS + 1)]) {
+                fprintf(stderr, "linearForcing rows must be ordered by start time. Exiting program..\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // components of the fast group for the multirate method, the others form the slow group
+    options -> fastComponents = NULL; options -> fastCount = 0;
+    buffer = json_object_get_array(data, "fastComponents");
+    if(buffer != NULL) {
+        options -> fastCount = json_array_get_count(buffer);
+        options -> fastComponents = (int *) malloc(sizeof(int) * (options -> fastCount + 1));
+        for (int k = 0; k < options -> fastCount; ++k) {
+            options -> fastComponents[k] = json_array_get_number(buffer, k);
+            if(options -> fastComponents[k] < 0 || options -> fastComponents[k] >= NSYS) {
+                fprintf(stderr, "fastComponents entries must be component indices 0 to %d. Exiting program..\n", NSYS - 1);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    options -> multirateRatio = json_object_has_value(data, "multirateRatio") ? json_object_get_number(data, "multirateRatio") : 4;
+    options -> splittingOrder = json_object_has_value(data, "splittingOrder") ? json_object_get_number(data, "splittingOrder") : 2;
+
+    // constant delays of the delay model; maxDelay bounds state-dependent ones
+    options -> delays = NULL; options -> delayCount = 0; options -> maxDelay = 0.0;
+    buffer = json_object_get_array(data, "delays");
+    if(buffer != NULL) {
+        options -> delayCount = json_array_get_count(buffer);
+        options -> delays = (double *) malloc(sizeof(double) * (options -> delayCount + 1));
+        for (int k = 0; k < options -> delayCount; ++k) {
+            options -> delays[k] = json_array_get_number(buffer, k);
+            if(options -> delays[k] < 0.0) {
+                fprintf(stderr, "delays must not be negative. Exiting program..\n");
+                exit(EXIT_FAILURE);
+            }
+            options -> maxDelay = (options -> delays[k] > options -> maxDelay) ? options -> delays[k] : options -> maxDelay;
+        }
+    }
+    if(json_object_has_value(data, "maxDelay")) {
+        options -> maxDelay = json_object_get_number(data, "maxDelay");
+    }
+
+    // Jacobian-free Newton-GMRES for the ESDIRK methods, by its Krylov subspace size
+    options -> krylovSize = json_object_has_value(data, "krylovSize") ? json_object_get_number(data, "krylovSize") : 0;
+
+    // bandwidths of the Jacobian for the banded Rosenbrock method: one number for both,
+    // or [lower, upper]
+    options -> bandLower = options -> bandUpper = -1;
+    if(json_object_has_value_of_type(data, "bandwidth", JSONNumber)) {
+        options -> bandLower = options -> bandUpper = json_object_get_number(data, "bandwidth");
+    } else if((buffer = json_object_get_array(data, "bandwidth")) != NULL) {
+        if(json_array_get_count(buffer) != 2) {
+            fprintf(stderr, "bandwidth needs one number or [lower, upper]. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        options -> bandLower = json_array_get_number(buffer, 0);
+        options -> bandUpper = json_array_get_number(buffer, 1);
+    }
+
+    options -> mixedPrecision = (bool) json_object_get_number(data, "mixedPrecision");
+
+    // finite difference Jacobians on a detected sparsity pattern, cached per model
+    options -> sparsityDetection = (bool) json_object_get_number(data, "sparsity");
+
+    // forward sensitivities to the parameters registered by setSensitivityParameters()
+    options -> sensitivities = (bool) json_object_get_number(data, "sensitivities");
+
+    // Monte Carlo ensemble of the stochastic methods, paths keyed by the seed
+    options -> seed = json_object_has_value(data, "seed") ? json_object_get_number(data, "seed") : 0;
+    options -> ensembleSize = json_object_has_value(data, "ensembleSize") ? json_object_get_number(data, "ensembleSize") : 1;
+
+    // right hand sides as expressions for the Taylor integrator, with named constants
+    buffer = json_object_get_array(data, "taylorModel");
+    if(buffer != NULL) {
+        if(json_array_get_count(buffer) != (size_t) NSYS) {
+            fprintf(stderr, "taylorModel needs %d expressions, one per component. Exiting program..\n", NSYS);
+            exit(EXIT_FAILURE);
+        }
+        JSON_Object *constants = json_object_get_object(data, "constants");
+        int constantCount = (constants != NULL) ? json_object_get_count(constants) : 0;
+        const char *expressions[NSYS], *names[constantCount + 1];
+        double values[constantCount + 1];
+        for (int var = 0; var < NSYS; ++var) {
+            expressions[var] = json_array_get_string(buffer, var);
+        }
+        for (int index = 0; index < constantCount; ++index) {
+            names[index] = json_object_get_name(constants, index);
+            values[index] = json_number(json_object_get_value_at(constants, index));
+        }
+        setTaylorModel(taylorParse(expressions, NSYS, names, values, constantCount));
+    }
+    options -> taylor = getTaylorModel();
 
     options -> printResult = json_object_get_number(data, "printResult");
     options -> plotTimeSeries = json_object_get_number(data, "plotTimeSeries");
@@ -98,7 +416,247 @@ odeOptions * readInput(const char *inputjson, int NSYS){
 void ODEinit(odeOptions *options, int (*events)(const double *, const double [])){
 
     // select solver method
-    (options -> adaptive == 1) ? (options -> method = "CashKarpRKF45") : specifySolverMethodInit(options);
+    specifySolverMethodInit(options);
+
+    if((options -> methodId == 16 || options -> methodId == 19 || options -> methodId == 24) && options -> adaptive == 0) {
+        printf("\t- %s controls its own stepsize, running adaptive..\n", options -> method);
+        options -> adaptive = 1;
+    }
+
+    // the exact propagator of a linear system steps from output point to output point
+    if(options -> methodId == 22) {
+        if(options -> adaptive == 1) {
+            printf("\t- %s is exact, running over the output grid..\n", options -> method);
+            options -> adaptive = 0;
+        }
+        options -> step = options -> outInterval;
+    }
+
+    // splitting steps at the fixed stepsize, each operator with its own method
+    if(options -> methodId == 25) {
+        if(splitOperatorCount() == 0) {
+            fprintf(stderr, "Splitting needs the operators of the model, register them with addSplitOperator() or addSplitFlow(). Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        if(options -> splittingOrder != 1 && options -> splittingOrder != 2) {
+            fprintf(stderr, "splittingOrder must be 1 (Lie) or 2 (Strang). Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        if(options -> adaptive == 1) {
+            printf("\t- %s runs at the fixed stepsize..\n", options -> method);
+            options -> adaptive = 0;
+        }
+        splitReset();
+    }
+
+    // stochastic steps cut each output interval into 2^sdeLevel nodes of the Brownian tree,
+    // the first level at or below the stepsize; SRA1 and SRIW1 move from there
+    options -> sdeAdaptive = false; options -> sdeLevel = 0;
+    if(options -> methodId >= 26 && options -> methodId <= 29) {
+        if(hasDiffusion() == false) {
+            fprintf(stderr, "%s needs the diffusion of the model, register it with setDiffusion(). Exiting program..\n", options -> method);
+            exit(EXIT_FAILURE);
+        }
+        if(options -> ensembleSize < 1) {
+            fprintf(stderr, "ensembleSize must be at least 1. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        // SRA1 keeps its strong order for additive noise only
+        if(options -> methodId == 28 && diffusionAdditive(options -> domain[0], options -> yInitCond, options -> NSYS) == false) {
+            fprintf(stderr, "%s is for additive noise, the diffusion depends on y: use SRIW1 (methodId 29). Exiting program..\n", options -> method);
+            exit(EXIT_FAILURE);
+        }
+        int level = (int) ceil(log2(options -> outInterval / options -> step) - 1.0e-9);
+        options -> sdeLevel = (level < 0) ? 0 : ((level > SDE_MAXDEPTH) ? SDE_MAXDEPTH : level);
+        options -> sdeAdaptive = (options -> adaptive == 1 && options -> methodId >= 28);
+        if(options -> adaptive == 1) {
+            printf("\t- %s %s..\n", options -> method, options -> sdeAdaptive ? "controls its steps within the output intervals" : "runs at the fixed stepsize");
+            options -> adaptive = 0;
+        }
+        options -> step = options -> outInterval;
+    }
+
+    // the sensitivities extend derivative() of a compiled model, and the methods that
+    // read other parts of the model or sized inputs for the state alone cannot step them
+    if(options -> sensitivities) {
+        if(options -> methodId == 19 || (options -> methodId >= 20 && options -> methodId != 21 && options -> methodId != 30) || options -> taylor != NULL) {
+            fprintf(stderr, "Sensitivities need derivative() and a method that steps it alone: methodId 1 to 18, 21 or 30. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        // the sensitivities couple to the state NSYS P components away, the band of the
+        // whole system comes from its pattern
+        if(options -> methodId == 30) {
+            if(options -> sparsityDetection == false) {
+                fprintf(stderr, "Sensitivities with %s need sparsity detection for the bandwidth of the whole system. Exiting program..\n", options -> method);
+                exit(EXIT_FAILURE);
+            }
+            options -> bandLower = -1;
+            options -> bandUpper = -1;
+        }
+        if(hasMOLModel() || hasDelayModel() || hasIMEXModel() || options -> massMatrix != NULL) {
+            fprintf(stderr, "Sensitivities apply to models of the form y' = f(t, y) through derivative(). Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        // the parameters are moved during a derivative evaluation
+        if(options -> threads > 1) {
+            printf("\t- Sensitivities evaluate the model on one thread..\n");
+            options -> threads = 1;
+        }
+    }
+
+    // a method-of-lines model has its unknowns on the grid, initial values from its function
+    if(hasMOLModel()) {
+        if(molSize() != options -> NSYS) {
+            fprintf(stderr, "The method-of-lines grid has %d unknowns, NSYS is %d. Exiting program..\n", molSize(), options -> NSYS);
+            exit(EXIT_FAILURE);
+        }
+        molInitial(options -> yInitCond);
+    }
+
+    // a mass matrix turns the model into M y' = f(t, y), solved by Radau IIA only
+    if(options -> massMatrix != NULL && options -> methodId != 16) {
+        fprintf(stderr, "massMatrix needs RadauIIA5 (methodId 16), the other methods solve y' = f(t, y). Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+    if(options -> massMatrix != NULL && hasDelayModel()) {
+        fprintf(stderr, "Delay models do not take a massMatrix. Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if(options -> methodId == 23 && hasIMEXModel() == false) {
+        fprintf(stderr, "ARK43 needs the explicit and implicit parts of the model, register them with setIMEXModel(). Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the history of a delay model is built from the interpolants of adaptive steps
+    if(hasDelayModel()) {
+        if(options -> methodId == 19 || options -> methodId == 20 || options -> methodId == 22 || options -> methodId == 23 || (options -> methodId >= 25 && options -> methodId <= 29)) {
+            fprintf(stderr, "%s does not step through the model derivative, delay models need another method. Exiting program..\n", options -> method);
+            exit(EXIT_FAILURE);
+        }
+        if(delayModelConstant() && options -> delayCount != delayModelCount()) {
+            fprintf(stderr, "The delay model needs %d constant delays as delays in the input file. Exiting program..\n", delayModelCount());
+            exit(EXIT_FAILURE);
+        }
+        if(delayModelConstant() == false && options -> maxDelay <= 0.0) {
+            fprintf(stderr, "State-dependent delays need their bound as maxDelay in the input file. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        options -> delayCount = delayModelCount();
+        if(options -> adaptive == 0) {
+            printf("\t- Delay models run adaptive..\n");
+            options -> adaptive = 1;
+        }
+    }
+
+    if(options -> methodId == 19 && options -> taylor == NULL) {
+        fprintf(stderr, "Taylor needs the right hand side as taylorModel expressions in the input file. Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+    // the tape evaluates into one set of coefficients shared by all its calls
+    if(options -> taylor != NULL && options -> threads > 1) {
+        printf("\t- The taylorModel expressions evaluate on one thread..\n");
+        options -> threads = 1;
+    }
+
+    // workspace for the adaptive steppers, the embedded pairs and their dense output
+    options -> yCurrent = NULL; options -> stages = NULL; options -> cont = NULL;
+    if(options -> adaptive == 1 || options -> methodId >= 9) {
+        options -> stages = (double *) malloc(sizeof(double) * 16 * options -> NSYS);
+        options -> cont = (double *) malloc(sizeof(double) * ((options -> methodId == 19) ? TAYLOR_MAXORDER + 1 : 8) * options -> NSYS);
+        options -> yCurrent = (double *) malloc(sizeof(double) * options -> NSYS);
+    }
+    options -> firstStageValid = false;
+    options -> stats = (odeStats) {0};
+
+    options -> radau = (options -> methodId == 16) ? radauAlloc(options -> NSYS, options -> massMatrix, options -> massDiagonal) : NULL;
+    options -> esdirk = NULL;
+    if(options -> methodId == 17 || options -> methodId == 18 || options -> methodId == 23) {
+        const esdirkTableau *tableau = (options -> methodId == 17) ? &TRBDF2_tableau : ((options -> methodId == 18) ? &ESDIRK43_tableau : &ARK43_tableau);
+        options -> esdirk = esdirkAlloc(tableau, options -> NSYS, options -> krylovSize);
+    }
+    if(options -> krylovSize != 0 && (options -> esdirk == NULL || options -> krylovSize < 0)) {
+        fprintf(stderr, "krylovSize must be positive and applies to TRBDF2, ESDIRK43 and ARK43 (methodId 17, 18, 23). Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+    if(hasPreconditioner() && options -> krylovSize == 0) {
+        printf("\t- The preconditioner applies to Newton-Krylov only, set krylovSize..\n");
+    }
+
+    // a method-of-lines model has the exact Jacobian of its stencil, a delay model
+    // evaluates its derivative on the history only while solving
+    options -> sparsity = NULL;
+    if(options -> sparsityDetection && hasMOLModel()) {
+        printf("\t- Method-of-lines models assemble their Jacobian from the stencil, no sparsity detection..\n");
+        options -> sparsityDetection = false;
+    }
+    if(options -> sparsityDetection && hasDelayModel()) {
+        fprintf(stderr, "Delay models do not take sparsity detection. Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // banded Jacobian: a method-of-lines model knows its stencil, other models give
+    // bandwidth or take it from their sparsity pattern in callODESolver()
+    options -> rosenbrock = NULL;
+    if(options -> methodId == 30) {
+        if(hasMOLModel()) {
+            molBandwidth(&options -> bandLower, &options -> bandUpper);
+        }
+        if((options -> bandLower < 0 || options -> bandUpper < 0) && options -> sparsityDetection == false) {
+            fprintf(stderr, "%s needs the bandwidth of the Jacobian as bandwidth in the input file, or sparsity detection. Exiting program..\n", options -> method);
+            exit(EXIT_FAILURE);
+        }
+        if(options -> bandLower >= 0 && options -> bandUpper >= 0) {
+            rosenbrockInit(options);
+        }
+    }
+    if(options -> mixedPrecision && options -> methodId != 30) {
+        fprintf(stderr, "mixedPrecision applies to the banded LU of ROS34PW2 (methodId 30). Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    options -> exponential = NULL;
+    if((options -> methodId == 20 || options -> methodId == 22) && options -> linearOperator == NULL) {
+        fprintf(stderr, "%s needs the linear part of the model as linearOperator in the input file. Exiting program..\n", options -> method);
+        exit(EXIT_FAILURE);
+    }
+    if(options -> methodId >= 20 && options -> methodId <= 22) {
+        options -> exponential = expAlloc(options -> NSYS, (options -> methodId != 21) ? options -> linearOperator : NULL, options -> linearDiagonal, options -> methodId == 22);
+    }
+
+    options -> multirate = NULL;
+    if(options -> methodId == 24) {
+        if(options -> fastCount == 0 || options -> fastCount == options -> NSYS) {
+            fprintf(stderr, "Multirate needs the fast group as fastComponents in the input file, leaving at least one slow component. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+        options -> multirate = multirateAlloc(options -> NSYS, options -> fastComponents, options -> fastCount, options -> multirateRatio);
+    }
+
+    options -> spectralVector = NULL; options -> spectralRadiusAge = 0;
+    if(options -> methodId == 15) {
+        options -> spectralVector = (double *) malloc(sizeof(double) * options -> NSYS);
+    }
+
+    // Bulirsch-Stoer starts at a table row suited to the tolerance, about 0.6 orders per digit
+    if(options -> methodId == 14) {
+        int row = (int) (-log10(options -> relErr + 1.0e-40) * 0.6 + 0.5);
+        options -> extrapolationRow = (row < 1) ? 1 : ((row > GBS_MAXROWS - 2) ? GBS_MAXROWS - 2 : row);
+        options -> order = 2 * (options -> extrapolationRow + 1);
+    }
+
+    // Taylor order from the tolerance, -ln(tol)/2 + 1 after Jorba and Zou
+    if(options -> methodId == 19) {
+        double tol = options -> relTol[0];
+        for (int var = 1; var < options -> NSYS; ++var) {
+            tol = (options -> relTol[var] < tol) ? options -> relTol[var] : tol;
+        }
+        int order = (int) ceil(-0.5 * log(tol) + 1.0);
+        options -> order = (order < 4) ? 4 : ((order > TAYLOR_MAXORDER) ? TAYLOR_MAXORDER : order);
+    }
+
+    options -> delay = hasDelayModel() ? ddeAlloc(options) : NULL;
+    options -> brownian = (options -> methodId >= 26 && options -> methodId <= 29) ? brownianAlloc(options -> NSYS, options -> seed) : NULL;
 
     options -> GRIDPOINTS = (largeInt) ((options -> domain[1] - options -> domain[0])/options -> outInterval) + 1;
 
@@ -113,7 +671,8 @@ void ODEinit(odeOptions *options, int (*events)(const double *, const double [])
        mkdir(filepath, S_IRWXU);
     }
 
-    sprintf(&filepath[strlen(filepath)], "/%s_step=%4.2le.csv", options -> method, options -> step);
+    sprintf(&filepath[strlen(filepath)], "/%s%s_step=%4.2le.csv", options -> method,
+            (options -> adaptive == 1 && options -> methodId <= 8) ? "-adaptive" : "", options -> step);
 
     options -> outputFilePath = (char *) malloc(sizeof(char) * (strlen(filepath) + 1));
     strcpy(options -> outputFilePath, filepath);
@@ -145,9 +704,39 @@ solution * ODESolver(void (*derivative)(const double *t, const double y[], doubl
     largeInt point;
     int eventflag = 0;
 
-    for (point = 0; gsl_vector_get(result -> dom, point) < options -> domain[1]; ++point) {
+    if(options -> adaptive == 1 && options -> denseOutput == 1) {
+        options -> tCurrent = options -> domain[0];
+        for (int var = 0; var < options -> NSYS; ++var) {
+            options -> yCurrent[var] = options -> yInitCond[var];
+        }
+    }
 
-        if(options -> adaptive == 1) {
+    // an ensemble of stochastic paths fills the output grid with their mean
+    point = (options -> methodId >= 26 && options -> methodId <= 29 && options -> ensembleSize > 1) ? sdeEnsemble(derivative, result, options) : 0;
+
+    for (; gsl_vector_get(result -> dom, point) < options -> domain[1]; ++point) {
+
+        if(options -> adaptive == 1 && options -> denseOutput == 1) {
+
+            // Realloc memory if array bounds exceeded
+
+            if(point + 1 == options -> GRIDPOINTS) {
+                realloc_gsl_containers(result, options);
+            }
+
+            endtime = gsl_vector_get(result -> dom, point) + options -> outInterval;
+
+            if(endtime > options -> domain[1]) {
+                endtime = options -> domain[1];
+            }
+
+            eventflag = denseODEIntegrate(derivative, result, options, point, endtime);
+
+            if(eventflag == 1) {
+                break;
+            }
+
+        } else if(options -> adaptive == 1) {
 
             // Realloc memory if array bounds exceeded
 
@@ -200,43 +789,188 @@ int adaptiveODEIntegrate(void (*derivative)(const double *t, const double y[], d
         func_y[var] = gsl_matrix_get(result -> func, var, point);
     }
 
+    adaptiveStep(derivative, &indep_t, func_y, &step, options);
+
+    // ===================== Check Event =========================
+    int eventflag = 0;
+    double eventTime, eventSol[options -> NSYS];
+
+    eventTime = gsl_vector_get(result -> dom, point);
+
+    for (int var = 0; var < options -> NSYS; ++var) {
+        eventSol[var] = (double) gsl_matrix_get(result -> func, var, point);
+    }
+
+    eventflag = options -> events(&eventTime, eventSol);
+
+    if(eventflag == 0) {
+        options -> step = step; // valid stepsize for next outer coarse loop step
+        gsl_vector_set(result -> dom, point + 1, indep_t);
+
+        for (int var = 0; var < options -> NSYS; ++var) {
+            gsl_matrix_set(result -> func, var, point + 1, func_y[var]);
+        }
+    }
+
+    return eventflag;
+
+}
+
+
+int denseODEIntegrate(void (*derivative)(const double *t, const double y[], double ydot[]), solution *result, odeOptions *options, largeInt point, double endtime) {
+
+    int eventflag = 0;
+    double theta, func_y[options -> NSYS];
+
+    // advance the adaptive solution until its last accepted step covers endtime
+    while(options -> tCurrent < endtime) {
+
+        eventflag = options -> events(&options -> tCurrent, options -> yCurrent);
+
+        if(eventflag == 1) {
+            return eventflag;
+        }
+
+        // the cubic Hermite interpolant is far below the order of the extrapolation and
+        // misses the exponential behaviour across the long steps of the exponential
+        // integrators and the fast group across a multirate macro step, so these steps
+        // are cut to land on the output grid instead
+        bool landing = ((options -> methodId == 14 || options -> methodId == 20 || options -> methodId == 21 || options -> methodId == 24) && options -> tCurrent + options -> step >= endtime);
+        if(landing) {
+            options -> step = endtime - options -> tCurrent;
+        }
+
+        options -> tPrevious = options -> tCurrent;
+        adaptiveStep(derivative, &options -> tCurrent, options -> yCurrent, &options -> step, options);
+
+        if(landing && fabs(options -> tCurrent - endtime) <= 4.0 * DBL_EPSILON * fabs(endtime)) {
+            options -> tCurrent = endtime;
+        }
+    }
+
+    // interpolate within [tPrevious, tCurrent]
+    theta = (endtime - options -> tPrevious)/(options -> tCurrent - options -> tPrevious);
+    denseInterpolate(theta, func_y, options);
+
+    gsl_vector_set(result -> dom, point + 1, endtime);
+
+    for (int var = 0; var < options -> NSYS; ++var) {
+        gsl_matrix_set(result -> func, var, point + 1, func_y[var]);
+    }
+
+    return eventflag;
+}
+
+
+// -- Adaptive Step Controller ------------------------------------------------
+
+// order of the continuous extension the output points are interpolated from when it is
+// below the order of the step, 0 where the steps land on the output grid or leave a
+// polynomial of their own order
+static int lowOrderInterpolant(const odeOptions *options){
+
+    int contOrder;
+
+    switch(options -> methodId) {
+        case 10: contOrder = 4; break;
+        case 11: case 14: case 16: case 19: case 20: case 21: case 22: case 24: case 25: return 0;
+        default: contOrder = 3; break;
+    }
+
+    return (contOrder < options -> order) ? contOrder : 0;
+}
+
+// Takes one accepted step from (t, y) with the adaptive stepper selected by methodId,
+// starting from the trial stepsize *step. On return (t, y) holds the new solution
+// and *step the stepsize for the next step. For denseOutput the continuous
+// extension of the accepted step is left in options -> cont.
+
+void adaptiveStep(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double *step, odeOptions *options) {
+
     // specify algorithm parameters
     // {'nonZeroScaffold': this parameter guards against driving step size to zero (infinitesimal)! }
-    static double safety = 0.9, errorMinBound = 5.7665e-4, nonZeroScaffold = 1.0e-30;
+    // {'errorMinBound': below this error signal the stepsize would grow by more than a factor of 4 }
+    static double safety = 0.9, nonZeroScaffold = 1.0e-30;
+    double shrinkExponent = -1.0/options -> order, growthExponent = -1.0/(options -> order + 1);
+    double errorMinBound = pow(4.0/safety, 1.0/growthExponent);
+    double h = *step, hnext;
     double errorMax;
-    double ytemp[options -> NSYS], errorSpectrum[options -> NSYS];
-    double dydt[options -> NSYS], yscal[options -> NSYS];
+    int trials = 0;
+    double ytemp[options -> NSYS];
+    double *dydt = options -> stages, yscal[options -> NSYS], noRelWeight[options -> NSYS];
+    errorNorm norm = { .absWeight = options -> absTol, .relWeight = options -> relTol, .type = options -> normType };
+
+    // first stage f(t, y): evaluated once per step and shared by the scaling and all trials
+    if(options -> firstStageValid == false) {
+        derivative(t, y, dydt);
+        options -> stats.rhsCalls += 1;
+    } else {
+        options -> stats.rhsSaved += 1; // carried over from the dense output of the previous step
+    }
 
-    derivative(&indep_t, func_y, dydt);
-    for (int var = 0; var < options -> NSYS; ++var) {
-        // around y[i] == 0, h * dydt = finite and nonZeroScaffold > 0 implies yscal[i] doesn't go to zero!
-        // for high values of y[i], h * dydt and nonZeroScaffold are negligible
-        yscal[var] = fabs(func_y[var]) + fabs(step * dydt[var]) + nonZeroScaffold;
+    if(options -> absTol == NULL) {
+        for (int var = 0; var < options -> NSYS; ++var) {
+            // around y[i] == 0, h * dydt = finite and nonZeroScaffold > 0 implies yscal[i] doesn't go to zero!
+            // for high values of y[i], h * dydt and nonZeroScaffold are negligible
+            yscal[var] = options -> relTol[var] * (fabs(y[var]) + fabs(h * dydt[var]) + nonZeroScaffold);
+            noRelWeight[var] = 0.0;
+        }
+        norm.absWeight = yscal; norm.relWeight = noRelWeight;
     }
 
-    if(indep_t + step > options -> domain[1]) {
-        step = options -> domain[1] - indep_t;
+    if(*t + h > options -> domain[1]) {
+        h = options -> domain[1] - *t;
     }
 
-    while(true) {
+    // steps of a delay model land on the jumps in the derivative carried by the lags
+    if(options -> delay != NULL) {
+        h = ddeLimitStep(options -> delay, *t, y, h);
+    }
+
+    if(options -> methodId == 15) {
+        chebyshevSetup(derivative, t, y, &h, options);
+    }
+
+    if(options -> methodId == 14) {
+
+        hnext = extrapolationStep(derivative, t, y, ytemp, &h, &norm, options);
+
+    } else if(options -> methodId == 16) {
+
+        hnext = RadauIIA5(derivative, t, y, ytemp, &h, &norm, options);
 
-        // trial solution
-        CashKarp_RKF45(derivative, &indep_t, func_y, ytemp, step, errorSpectrum, options -> NSYS);
+    } else if(options -> methodId == 19) {
 
-        // determine error signal from trial solution
-        errorMax = 0.0;
-        for (int var = 0; var < options -> NSYS; ++var){
-            errorMax = FMAX(errorMax, fabs(errorSpectrum[var]/yscal[var]));
+        hnext = TaylorStep(t, y, ytemp, &h, &norm, options);
+
+    } else if(options -> methodId == 24) {
+
+        hnext = MultirateStep(derivative, t, y, ytemp, &h, &norm, options);
+
+    } else while(true) {
+
+        // trial solution and its error signal, weighted by the tolerances
+        errorMax = adaptiveSolver(derivative, t, y, ytemp, h, &norm, options);
+        if(options -> firstStageShared == true) {
+            options -> stats.rhsCalls += options -> stageCount - 1;
+            // f(t, y) of the step is counted once above, as evaluated or carried over
+            if(trials > 0) {
+                options -> stats.rhsSaved += 1; // not re-evaluated for this retry
+            }
+        } else {
+            options -> stats.rhsCalls += options -> stageCount;
         }
-        errorMax /= options -> relErr;
+        trials += 1;
 
         // step modification based on error feedback
         if(errorMax > 1.0) {
 
+            options -> stats.rejected += 1;
+
             // scale down stepsize by a maximum factor of 4
-            step = FMAX(fabs(safety * step * pow(errorMax, -0.25)), 0.25 * fabs(step));
+            h = FMAX(fabs(safety * h * pow(errorMax, shrinkExponent)), 0.25 * fabs(h));
 
-            if(indep_t + step == indep_t) {
+            if(*t + h == *t) {
                 fprintf(stderr, "\nstepsize underflow in adaptive stepper algorithm..now exiting to system\n");
                 exit(1);
             }
@@ -246,44 +980,223 @@ int adaptiveODEIntegrate(void (*derivative)(const double *t, const double y[], d
 
             // errorMax driven to less than 1
 
-            indep_t = indep_t + step; // advance time step
-            for (int var = 0; var < options -> NSYS; ++var) {
-                func_y[var] = ytemp[var]; // advance solution by finer time step
-            }
+            options -> stats.accepted += 1;
 
             // scale up stepsize by a maximum factor of 4 only
-            step = (errorMax > errorMinBound) ? safety * step * pow(errorMax, -0.20) : (4.0 * step); // valid stepsize for next step
+            hnext = (errorMax > errorMinBound) ? safety * h * pow(errorMax, growthExponent) : (4.0 * h);
 
             break; // out of inner loop, solution for this step successful based on specified error
         }
     } // end inner while loop
 
-    // ===================== Check Event =========================
-    int eventflag = 0;
-    double eventTime, eventSol[options -> NSYS];
+    // f(t + h, ytemp) closes the dense output and is the first stage of the next step;
+    // a delay model keeps the dense output of every step as its history
+    options -> firstStageValid = options -> fsal;
+    if(options -> denseOutput == 1 || options -> delay != NULL) {
+        if(options -> fsal == false) {
+            double t_new = *t + h;
+            derivative(&t_new, ytemp, &options -> stages[options -> fsalSlot * options -> NSYS]);
+            options -> stats.rhsCalls += 1;
+        }
 
-    eventTime = gsl_vector_get(result -> dom, point);
+        denseSolver(derivative, t, y, ytemp, h, options);
+        options -> stats.rhsCalls += options -> denseStageCount;
+        options -> firstStageValid = true;
+    }
+
+    // the lags read the dense output of the step, and so do the output points of an
+    // interpolant below the order of the step, which its error estimate does not cover:
+    // the residual of the interpolant rejects the step like the error estimate, and sets
+    // the next stepsize with it
+    double residual = 0.0;
+    int contOrder = lowOrderInterpolant(options);
+    if(options -> delay != NULL) {
+        residual = ddeRecord(options -> delay, derivative, &norm, *t, y, ytemp, h, options -> cont);
+        contOrder = options -> delay -> contOrder;
+        options -> stats.rhsCalls += 2;
+    } else if(options -> denseOutput == 1 && contOrder > 0) {
+        residual = interpolantResidual(derivative, options -> methodId, options -> cont, *t, h, &norm, options -> NSYS) / (contOrder + 1);
+        options -> stats.rhsCalls += 2;
+    }
+
+    if(residual > 0.0) {
+        double hlag = safety * h * pow(residual, -1.0 / (contOrder + 1));
+
+        if(residual > 1.0) {
+            // repeated from f(t, y), still in stages[0]
+            options -> stats.accepted -= 1;
+            options -> stats.rejected += 1;
+            options -> firstStageValid = true;
+            double hretry = FMAX((hlag < 0.5 * h) ? hlag : 0.5 * h, 0.25 * h);
+            *step = hretry;
+            adaptiveStep(derivative, t, y, step, options);
+            *step = (*step > hretry) ? hretry : *step; // no growth right after a rejection
+            return;
+        }
+        hnext = (hlag < hnext) ? hlag : hnext;
+    }
+
+    if(options -> firstStageValid == true) {
+        for (int var = 0; var < options -> NSYS; ++var) {
+            dydt[var] = options -> stages[options -> fsalSlot * options -> NSYS + var];
+        }
+    }
 
+    *t = *t + h; // advance time step
     for (int var = 0; var < options -> NSYS; ++var) {
-        eventSol[var] = (double) gsl_matrix_get(result -> func, var, point);
+        y[var] = ytemp[var]; // advance solution by finer time step
     }
 
-    eventflag = options -> events(&eventTime, eventSol);
+    *step = hnext; // valid stepsize for next step
 
-    if(eventflag == 0) {
-        options -> step = step; // valid stepsize for next outer coarse loop step
-        gsl_vector_set(result -> dom, point + 1, indep_t);
+}
 
-        for (int var = 0; var < options -> NSYS; ++var) {
-            gsl_matrix_set(result -> func, var, point + 1, func_y[var]);
+
+// -- Chebyshev Stage Setup ---------------------------------------------------
+
+// RKC needs the spectral radius of the Jacobian at (t, y), with f(t, y) in stages[0]: it
+// is taken from the input file or re-estimated by power iteration every 25 steps. The
+// stepsize *h is capped at the stability interval of RKC_MAXSTAGES stages.
+
+void chebyshevSetup(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double *h, odeOptions *options) {
+
+    if(options -> spectralRadiusFixed == false && options -> spectralRadiusAge % 25 == 0) {
+        int calls = 0;
+
+        // the first iteration starts along f(t, y) with alternating weights, so the dominant mode
+        // is present even when f(t, y) is a smooth eigenvector; later ones along the last direction found
+        for (int var = 0; options -> spectralRadiusAge == 0 && var < options -> NSYS; ++var) {
+            options -> spectralVector[var] = ((var % 2 == 0) ? 0.5 : 1.5) * options -> stages[var];
         }
+
+        options -> spectralRadius = spectralRadius(derivative, t, y, options -> stages, options -> spectralVector, &calls, options -> NSYS);
+        options -> stats.rhsCalls += calls;
     }
+    options -> spectralRadiusAge += 1;
 
-    return eventflag;
+    if(options -> spectralRadius > 0.0) {
+        double hmax = ((double) RKC_MAXSTAGES * RKC_MAXSTAGES - 1.0) / (1.54 * options -> spectralRadius);
+        *h = (*h > hmax) ? hmax : *h;
+    }
+}
+
+
+// -- Extrapolation Step Controller -------------------------------------------
+
+// One accepted Gragg-Bulirsch-Stoer step with order and stepsize control after Hairer,
+// Norsett & Wanner (ODEX). options -> extrapolationRow is the target row k of the table,
+// whose convergence is checked at rows k - 1, k and k + 1; the order for the next step
+// is the one with the least derivative evaluations per unit step. *h enters as the
+// trial stepsize and leaves as the accepted one. Returns the stepsize for the next step.
+
+double extrapolationStep(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double *h, const errorNorm *norm, odeOptions *options) {
+
+    // {'safety1, safety2': target error 0.65 and safety factor 0.94 of the optimal stepsizes }
+    static double safety1 = 0.65, safety2 = 0.94, maxGrowth = 4.0;
+    int NSYS = options -> NSYS, k = options -> extrapolationRow, row, lastRow;
+    bool parallel = options -> threads > 1, rejected = false;
+    double *table = &options -> stages[NSYS], *dydt = options -> stages;
+    double err, fac, expo, hnext;
+    double hopt[GBS_MAXROWS], work[GBS_MAXROWS], cost[GBS_MAXROWS];
+
+    // derivative evaluations up to each row, f(t, y) included
+    cost[0] = GBS_SUBSTEPS(0) + 1;
+    for (row = 1; row < GBS_MAXROWS; ++row) {
+        cost[row] = cost[row - 1] + GBS_SUBSTEPS(row);
+    }
+
+    while(true) {
+
+        lastRow = k + 1;
+
+        // in parallel all rows up to k + 1 are computed at once, serially only as far as needed
+        if(parallel) {
+            GBS_rows(derivative, t, y, dydt, *h, 0, lastRow, table, options -> threads, NSYS);
+            options -> stats.rhsCalls += cost[lastRow] - 1;
+        }
+
+        for (row = 0; row <= lastRow; ++row) {
+
+            if(!parallel) {
+                GBS_rows(derivative, t, y, dydt, *h, row, row, table, 1, NSYS);
+                options -> stats.rhsCalls += GBS_SUBSTEPS(row);
+            }
+
+            err = GBS_extrapolate(row, table, y, ytemp, norm, NSYS);
+
+            if(row == 0) {
+                continue;
+            }
+
+            // optimal stepsize and work per unit step for the order of this row
+            expo = 1.0/(2 * row + 1);
+            fac = safety2 * pow(safety1/err, expo);
+            fac = FMAX(fac, pow(0.02, expo));
+            fac = (fac > maxGrowth) ? maxGrowth : fac;
+            hopt[row] = *h * fac;
+            work[row] = cost[row] / hopt[row];
+
+            // convergence monitor: accept, or give up early when row k + 1 cannot converge
+            if(row >= k - 1) {
+                if(err <= 1.0) {
+                    break;
+                }
+                if(row == k - 1 && err > pow((double) GBS_SUBSTEPS(k + 1) * GBS_SUBSTEPS(k) / (GBS_SUBSTEPS(0) * GBS_SUBSTEPS(0)), 2)) {
+                    break;
+                }
+                if(row == k && err > pow((double) GBS_SUBSTEPS(k + 1) / GBS_SUBSTEPS(0), 2)) {
+                    break;
+                }
+            }
+        }
+
+        // f(t, y) is shared by all rows, and a retry takes it from the first trial
+        if(rejected) {
+            options -> stats.rhsSaved += 1;
+        }
+
+        row = (row > lastRow) ? lastRow : row;
+
+        if(err <= 1.0) {
+            break;
+        }
+
+        // rejected: retry at the cheaper of the orders tried so far
+        options -> stats.rejected += 1;
+        rejected = true;
+
+        k = (row < k) ? row : k;
+        if(k >= 2 && work[k - 1] < 0.8 * work[k]) {
+            k -= 1;
+        }
+        *h = hopt[k];
+
+        if(*t + *h == *t) {
+            fprintf(stderr, "\nstepsize underflow in extrapolation algorithm..now exiting to system\n");
+            exit(1);
+        }
+    }
+
+    options -> stats.accepted += 1;
+
+    // order for the next step: lower it if cheaper, raise it if the work keeps decreasing
+    k = row;
+    if(row >= 2 && work[row - 1] < 0.8 * work[row]) {
+        k = row - 1;
+    } else if(!rejected && row < GBS_MAXROWS - 2 && (row == 1 || work[row] < 0.9 * work[row - 1])) {
+        k = row + 1;
+    }
+
+    hnext = (k <= row) ? hopt[k] : hopt[row] * cost[k] / cost[row];
+
+    options -> extrapolationRow = k;
+    options -> order = 2 * (k + 1);
 
+    return hnext;
 }
 
 
+
 void ODEIntegrate(void (*derivative)(const double *t, const double y[], double ydot[]), solution *result, odeOptions *options, largeInt point, double endtime){
 
     double step = options -> step;
@@ -323,6 +1236,135 @@ void genericSolver(void (*derivative)(const double *t, const double y[], double
         case 6: RK3Optim(derivative, t, y, step, options -> NSYS); break;
         case 7: RK4(derivative, t, y, step, options -> NSYS); break;
         case 8: RK5Butcher(derivative, t, y, step, options -> NSYS); break;
+        case 20: ETDRK4(derivative, t, y, step, options -> NSYS); break;
+        case 22: LinearExpm(derivative, t, y, step, options); break;
+        case 25: SplitStep(t, y, step, options); break;
+        case 26: case 27: case 28: case 29: SDEStep(derivative, t, y, step, options); break;
+        case 14: {
+            // extrapolation at the initial order, no convergence monitor
+            double ytemp[options -> NSYS], *table = &options -> stages[options -> NSYS];
+            int lastRow = options -> extrapolationRow;
+            derivative(t, y, options -> stages);
+            GBS_rows(derivative, t, y, options -> stages, step, 0, lastRow, table, options -> threads, options -> NSYS);
+            for (int row = 0; row <= lastRow; ++row) {
+                GBS_extrapolate(row, table, y, ytemp, NULL, options -> NSYS);
+            }
+            for (int var = 0; var < options -> NSYS; ++var) {
+                y[var] = ytemp[var];
+            }
+            *t = *t + step;
+            break;
+        }
+        case 15: {
+            // Chebyshev stages chosen for the fixed stepsize, error estimate discarded
+            double ytemp[options -> NSYS];
+            derivative(t, y, options -> stages);
+            chebyshevSetup(derivative, t, y, &step, options);
+            RKC(derivative, t, y, ytemp, step, NULL, options -> stages, RKC_stages(step, options -> spectralRadius), options -> NSYS);
+            for (int var = 0; var < options -> NSYS; ++var) {
+                y[var] = ytemp[var];
+            }
+            *t = *t + step;
+            break;
+        }
+        case 9: case 10: case 11: case 12: case 13: case 17: case 18: case 21: case 23: case 30: {
+            // embedded pairs run at fixed stepsize, error estimate discarded
+            double ytemp[options -> NSYS];
+            derivative(t, y, options -> stages);
+            adaptiveSolver(derivative, t, y, ytemp, step, NULL, options);
+            for (int var = 0; var < options -> NSYS; ++var) {
+                y[var] = ytemp[var];
+            }
+            *t = *t + step;
+            break;
+        }
+    }
+
+}
+
+double adaptiveSolver(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double *y, double *ytemp, double step, const errorNorm *norm, odeOptions *options){
+
+    switch(options -> methodId) {
+        case 1: return Richardson(FWEuler, 1, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 2: return HeunEuler21(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 3: return Richardson(Midpoint, 2, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 4: return Richardson(RK2Ralston, 2, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 5: return Richardson(RK3Classic, 3, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 6: return Richardson(RK3Optim, 3, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 7: return Richardson(RK4, 4, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 8: return Richardson(RK5Butcher, 5, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 9: return CashKarp_RKF45(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 10: return Verner65(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 11: return DOP853(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 12: return BogackiShampine32(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 13: return Fehlberg45(derivative, t, y, ytemp, step, norm, options -> stages, options -> NSYS);
+        case 17: case 18: case 23: return ESDIRK(derivative, t, y, ytemp, step, norm, options);
+        case 20: return Richardson(ETDRK4, 4, derivative, t, y, ytemp, step, norm, options -> NSYS);
+        case 21: return ExpRosenbrock43(derivative, t, y, ytemp, step, norm, options);
+        case 30: return ROS34PW2(derivative, t, y, ytemp, step, norm, options);
+        case 15:
+            options -> stageCount = RKC_stages(step, options -> spectralRadius) + 1;
+            return RKC(derivative, t, y, ytemp, step, norm, options -> stages, options -> stageCount - 1, options -> NSYS);
+    }
+
+    return 0.0;
+}
+
+void denseSolver(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double *y, const double *ytemp, double step, odeOptions *options){
+
+    switch(options -> methodId) {
+        case 10: Verner65_contd(y, step, options -> stages, options -> cont, options -> NSYS); break;
+        case 11: DOP853_contd(derivative, t, y, ytemp, step, options -> stages, options -> cont, options -> NSYS); break;
+        case 16: break; // collocation polynomial left in cont by the step
+        case 19: break; // Taylor polynomial left in cont by the step
+        default: Hermite_contd(y, ytemp, options -> stages, &options -> stages[options -> fsalSlot * options -> NSYS], step, options -> cont, options -> NSYS); break;
+    }
+
+}
+
+// Residual h |p' - f(t + theta h, p)| of the continuous extension p of methodId over
+// the step [t, t + h] in the error norm, for the interpolants the error estimate of the
+// step does not cover. Taken at a quarter and three quarters of the step, since the
+// leading error of a cubic Hermite interpolant is flat halfway, with p' from the
+// interpolant itself. Two derivative evaluations.
+double interpolantResidual(void (*derivative)(const double *t, const double y[], double ydot[]), int methodId, const double cont[], double t, double h, const errorNorm *norm, int NSYS){
+
+    static double samples[] = {0.25, 0.75};
+    double residual = 0.0;
+
+    for (int sample = 0; sample < 2; ++sample) {
+        double theta = samples[sample], tSample = t + theta * h;
+        double yp[NSYS], slope[NSYS], f[NSYS], sumSquares = 0.0, maxRatio = 0.0, ratio;
+
+        switch(methodId) {
+            case 10: polynomial_dense(theta, cont, 4, yp, NSYS); polynomial_slope(theta, cont, 4, slope, NSYS); break;
+            case 11: DOP853_dense(theta, cont, yp, NSYS); DOP853_slope(theta, cont, slope, NSYS); break;
+            case 16: Radau_dense(theta, cont, yp, NSYS); Radau_slope(theta, cont, slope, NSYS); break;
+            default: polynomial_dense(theta, cont, 3, yp, NSYS); polynomial_slope(theta, cont, 3, slope, NSYS); break;
+        }
+        derivative(&tSample, yp, f);
+
+        for (int var = 0; var < NSYS; ++var) {
+            ratio = fabs(slope[var] - h * f[var]) / (norm -> absWeight[var] + norm -> relWeight[var] * fabs(yp[var]));
+            sumSquares += ratio * ratio;
+            maxRatio = (ratio > maxRatio) ? ratio : maxRatio;
+        }
+
+        ratio = (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+        residual = (ratio > residual) ? ratio : residual;
+    }
+
+    return residual;
+}
+
+void denseInterpolate(double theta, double *y, odeOptions *options){
+
+    switch(options -> methodId) {
+        case 10: polynomial_dense(theta, options -> cont, 4, y, options -> NSYS); break;
+        case 11: DOP853_dense(theta, options -> cont, y, options -> NSYS); break;
+        case 16: Radau_dense(theta, options -> cont, y, options -> NSYS); break;
+        case 19: polynomial_dense(theta, options -> cont, options -> order, y, options -> NSYS); break;
+        default: polynomial_dense(theta, options -> cont, 3, y, options -> NSYS); break;
     }
 
 }
@@ -8,11 +8,25 @@
 #include "algorithms.h"
 #include <stdio.h>
 #include <math.h>
+#include <pthread.h>
 
 // -- Macro/Inline Functions ---------------------------------------------------------
 
 #define FMAX(x, y) ( x > y ? x : y )
 
+// error weight of one component, see errorNorm in algorithms.h; fixed stepsize runs pass norm = NULL
+static inline double errorWeight(const errorNorm *norm, int index, double y, double ynew){
+    return (norm == NULL) ? 1.0 : norm -> absWeight[index] + norm -> relWeight[index] * FMAX(fabs(y), fabs(ynew));
+}
+
+// both reductions are accumulated in the same sweep, the norm type only picks one at the end
+static inline double errorReduce(const errorNorm *norm, double sumSquares, double maxRatio, int NSYS){
+    if(norm == NULL) {
+        return 0.0;
+    }
+    return (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+}
+
 // ----------------------------------------------------------------------------
 //
 //                            Non Adaptive systems algorithms
@@ -284,7 +298,11 @@ void RK5Butcher(void (*derivative)(const double *t, const double y[], double ydo
 //
 // ----------------------------------------------------------------------------
 
-void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, double errorSpectrum[], int NSYS){
+// Method ID = 9
+// The embedded pairs take the first stage f(t, y) from K[0..NSYS) instead of evaluating it,
+// so it is shared by the stepsize scaling and every trial of a step. K[] receives the
+// remaining stages (6 * NSYS here), with one more slot kept free for f(t + h, ytemp).
+double CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
 
     // -- Parameters ----------------------------------------------------------
     static double
@@ -300,9 +318,10 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
     // --  ------------------------------------------------------------------------
 
     double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS],
+           *K5 = &K[4 * NSYS], *K6 = &K[5 * NSYS];
 
-    // Block 1 Calculations -------------------
-    double K1[NSYS]; derivative(t, y, K1);
+    // Block 1 Calculations: K1 supplied by the caller
 
     // Block 2 Calculations -------------------
     t_int = *t + p1 * step;
@@ -310,7 +329,7 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
         y_int[index] = y[index] + (q11 * K1[index]) * step;
     }
 
-    double K2[NSYS]; derivative(&t_int, y_int, K2);
+    derivative(&t_int, y_int, K2);
 
     // Block 3 Calculations -------------------
     t_int = *t + p2 * step;
@@ -318,7 +337,7 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
         y_int[index] = y[index] + (q21 * K1[index] + q22 * K2[index]) * step;
     }
 
-    double K3[NSYS]; derivative(&t_int, y_int, K3);
+    derivative(&t_int, y_int, K3);
 
     // Block 4 Calculations -------------------
     t_int = *t + p3 * step;
@@ -326,7 +345,7 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
         y_int[index] = y[index] + (q31 * K1[index] + q32 * K2[index] + q33 * K3[index]) * step;
     }
 
-    double K4[NSYS]; derivative(&t_int, y_int, K4);
+    derivative(&t_int, y_int, K4);
 
     // Block 5 Calculations -------------------
     t_int = *t + p4 * step;
@@ -334,7 +353,7 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
         y_int[index] = y[index] + (q41 * K1[index] + q42 * K2[index] + q43 * K3[index] + q44 * K4[index]) * step;
     }
 
-    double K5[NSYS]; derivative(&t_int, y_int, K5);
+    derivative(&t_int, y_int, K5);
 
     // Block 6 Calculations -------------------
     t_int = *t + p5 * step;
@@ -342,19 +361,984 @@ void CashKarp_RKF45(void (*derivative)(const double *t, const double y[], double
         y_int[index] = y[index] + (q51 * K1[index] + q52 * K2[index] + q53 * K3[index] + q54 * K4[index] + q55 * K5[index]) * step;
     }
 
-    double K6[NSYS]; derivative(&t_int, y_int, K6);
+    derivative(&t_int, y_int, K6);
 
-    // i+1 Increment Step and errors
-    double slope[NSYS];
+    // i+1 Increment Step and errors, fused with the error norm in one sweep
+    double slope, ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        slope = a1 * K1[index] + a3 * K3[index] + a4 * K4[index] + a6 * K6[index];
+
+        ytemp[index] = y[index] + slope * step;
+
+        ratio = (d1 * K1[index] + d3 * K3[index] + d4 * K4[index] + d5 * K5[index] + d6 * K6[index]) * step
+              / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 10
+// Verner 6(5) pair: the 6th order solution is advanced and the embedded 5th order
+// solution provides the error estimate. K[] holds the eight stages (8 * NSYS), K1
+// supplied by the caller, with one more slot kept free for Verner65_contd.
+double Verner65(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        p1 = 1.0/6.0, q11 = 1.0/6.0,
+        p2 = 4.0/15.0, q21 = 4.0/75.0, q22 = 16.0/75.0,
+        p3 = 2.0/3.0, q31 = 5.0/6.0, q32 = -8.0/3.0, q33 = 2.5,
+        p4 = 5.0/6.0, q41 = -165.0/64.0, q42 = 55.0/6.0, q43 = -425.0/64.0, q44 = 85.0/96.0,
+        p5 = 1.0, q51 = 2.4, q52 = -8.0, q53 = 4015.0/612.0, q54 = -11.0/36.0, q55 = 88.0/255.0,
+        p6 = 1.0/15.0, q61 = -8263.0/15000.0, q62 = 124.0/75.0, q63 = -643.0/680.0, q64 = -81.0/250.0, q65 = 2484.0/10625.0,
+        p7 = 1.0, q71 = 3501.0/1720.0, q72 = -300.0/43.0, q73 = 297275.0/52632.0, q74 = -319.0/2322.0, q75 = 24068.0/84065.0, q77 = 3850.0/26703.0,
+        a1 = 3.0/40.0, a3 = 875.0/2244.0, a4 = 23.0/72.0, a5 = 264.0/1955.0, a7 = 125.0/11592.0, a8 = 43.0/616.0,
+        d1 = (3.0/40.0) - (13.0/160.0), d3 = (875.0/2244.0) - (2375.0/5984.0), d4 = (23.0/72.0) - (5.0/16.0),
+        d5 = (264.0/1955.0) - (12.0/85.0), d6 = -(3.0/44.0), d7 = 125.0/11592.0, d8 = 43.0/616.0;
+
+    // --  ------------------------------------------------------------------------
+
+    double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS],
+           *K5 = &K[4 * NSYS], *K6 = &K[5 * NSYS], *K7 = &K[6 * NSYS], *K8 = &K[7 * NSYS];
+
+    // Block 1 Calculations: K1 supplied by the caller
 
+    // Block 2 Calculations -------------------
+    t_int = *t + p1 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q11 * K1[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K2);
+
+    // Block 3 Calculations -------------------
+    t_int = *t + p2 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q21 * K1[index] + q22 * K2[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K3);
+
+    // Block 4 Calculations -------------------
+    t_int = *t + p3 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q31 * K1[index] + q32 * K2[index] + q33 * K3[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K4);
+
+    // Block 5 Calculations -------------------
+    t_int = *t + p4 * step;
     for (int index = 0; index < NSYS; ++index) {
-        slope[index] = a1 * K1[index] + a3 * K3[index] + a4 * K4[index] + a6 * K6[index];
+        y_int[index] = y[index] + (q41 * K1[index] + q42 * K2[index] + q43 * K3[index] + q44 * K4[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K5);
+
+    // Block 6 Calculations -------------------
+    t_int = *t + p5 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q51 * K1[index] + q52 * K2[index] + q53 * K3[index] + q54 * K4[index] + q55 * K5[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K6);
+
+    // Block 7 Calculations -------------------
+    t_int = *t + p6 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q61 * K1[index] + q62 * K2[index] + q63 * K3[index] + q64 * K4[index] + q65 * K5[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K7);
+
+    // Block 8 Calculations -------------------
+    t_int = *t + p7 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q71 * K1[index] + q72 * K2[index] + q73 * K3[index] + q74 * K4[index] + q75 * K5[index] + q77 * K7[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K8);
+
+    // i+1 Increment Step and errors, fused with the error norm in one sweep
+    double slope, ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        slope = a1 * K1[index] + a3 * K3[index] + a4 * K4[index] + a5 * K5[index] + a7 * K7[index] + a8 * K8[index];
+
+        ytemp[index] = y[index] + slope * step;
+
+        ratio = (d1 * K1[index] + d3 * K3[index] + d4 * K4[index] + d5 * K5[index] + d6 * K6[index] + d7 * K7[index] + d8 * K8[index]) * step
+              / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 11
+// Dormand-Prince 8(5,3) pair (DOP853, Hairer, Norsett & Wanner). The 8th order solution
+// is advanced and the 5th and 3rd order estimates are blended into a single error signal
+// that behaves like O(h^8). K[] holds the twelve stages (12 * NSYS), K1 supplied by
+// the caller, with four more slots kept free for DOP853_contd.
+double DOP853(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        c2 = 0.526001519587677318785587544488e-01, c3 = 0.789002279381515978178381316732e-01,
+        c4 = 0.118350341907227396726757197510, c5 = 0.281649658092772603273242802490,
+        c6 = 0.333333333333333333333333333333, c7 = 0.25, c8 = 0.307692307692307692307692307692,
+        c9 = 0.651282051282051282051282051282, c10 = 0.6, c11 = 0.857142857142857142857142857142,
+
+        a21 = 5.26001519587677318785587544488e-2,
+        a31 = 1.97250569845378994544595329183e-2, a32 = 5.91751709536136983633785987549e-2,
+        a41 = 2.95875854768068491816892993775e-2, a43 = 8.87627564304205475450678981324e-2,
+        a51 = 2.41365134159266685502369798665e-1, a53 = -8.84549479328286085344864962717e-1, a54 = 9.24834003261792003115737966543e-1,
+        a61 = 3.7037037037037037037037037037e-2, a64 = 1.70828608729473871279604482173e-1, a65 = 1.25467687566822425016691814123e-1,
+        a71 = 3.7109375e-2, a74 = 1.70252211019544039314978060272e-1, a75 = 6.02165389804559606850219397283e-2, a76 = -1.7578125e-2,
+        a81 = 3.70920001185047927108779319836e-2, a84 = 1.70383925712239993810214054705e-1, a85 = 1.07262030446373284651809199168e-1,
+        a86 = -1.53194377486244017527936158236e-2, a87 = 8.27378916381402288758473766002e-3,
+        a91 = 6.24110958716075717114429577812e-1, a94 = -3.36089262944694129406857109825, a95 = -8.68219346841726006818189891453e-1,
+        a96 = 2.75920996994467083049415600797e1, a97 = 2.01540675504778934086186788979e1, a98 = -4.34898841810699588477366255144e1,
+        a101 = 4.77662536438264365890433908527e-1, a104 = -2.48811461997166764192642586468, a105 = -5.90290826836842996371446475743e-1,
+        a106 = 2.12300514481811942347288949897e1, a107 = 1.52792336328824235832596922938e1, a108 = -3.32882109689848629194453265587e1,
+        a109 = -2.03312017085086261358222928593e-2,
+        a111 = -9.3714243008598732571704021658e-1, a114 = 5.18637242884406370830023853209, a115 = 1.09143734899672957818500254654,
+        a116 = -8.14978701074692612513997267357, a117 = -1.85200656599969598641566180701e1, a118 = 2.27394870993505042818970056734e1,
+        a119 = 2.49360555267965238987089396762, a1110 = -3.0467644718982195003823669022,
+        a121 = 2.27331014751653820792359768449, a124 = -1.05344954667372501984066689879e1, a125 = -2.00087205822486249909675718444,
+        a126 = -1.79589318631187989172765950534e1, a127 = 2.79488845294199600508499808837e1, a128 = -2.85899827713502369474065508674,
+        a129 = -8.87285693353062954433549289258, a1210 = 1.23605671757943030647266201528e1, a1211 = 6.43392746015763530355970484046e-1,
+
+        b1 = 5.42937341165687622380535766363e-2, b6 = 4.45031289275240888144113950566, b7 = 1.89151789931450038304281599044,
+        b8 = -5.8012039600105847814672114227, b9 = 3.1116436695781989440891606237e-1, b10 = -1.52160949662516078556178806805e-1,
+        b11 = 2.01365400804030348374776537501e-1, b12 = 4.47106157277725905176885569043e-2,
+
+        bhh1 = 0.244094488188976377952755905512, bhh2 = 0.733846688281611857341361741547, bhh3 = 0.220588235294117647058823529412e-01,
+
+        er1 = 0.1312004499419488073250102996e-01, er6 = -0.1225156446376204440720569753e+01, er7 = -0.4957589496572501915214079952,
+        er8 = 0.1664377182454986536961530415e+01, er9 = -0.3503288487499736816886487290, er10 = 0.3341791187130174790297318841,
+        er11 = 0.8192320648511571246570742613e-01, er12 = -0.2235530786388629525884427845e-01;
+
+    // --  ------------------------------------------------------------------------
+
+    double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS],
+           *K5 = &K[4 * NSYS], *K6 = &K[5 * NSYS], *K7 = &K[6 * NSYS], *K8 = &K[7 * NSYS],
+           *K9 = &K[8 * NSYS], *K10 = &K[9 * NSYS], *K11 = &K[10 * NSYS], *K12 = &K[11 * NSYS];
+
+    // Block 1 Calculations: K1 supplied by the caller
+
+    // Block 2 Calculations -------------------
+    t_int = *t + c2 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a21 * K1[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K2);
+
+    // Block 3 Calculations -------------------
+    t_int = *t + c3 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a31 * K1[index] + a32 * K2[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K3);
+
+    // Block 4 Calculations -------------------
+    t_int = *t + c4 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a41 * K1[index] + a43 * K3[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K4);
+
+    // Block 5 Calculations -------------------
+    t_int = *t + c5 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a51 * K1[index] + a53 * K3[index] + a54 * K4[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K5);
+
+    // Block 6 Calculations -------------------
+    t_int = *t + c6 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a61 * K1[index] + a64 * K4[index] + a65 * K5[index]) * step;
+    }
 
-        ytemp[index] = y[index] + slope[index] * step;
+    derivative(&t_int, y_int, K6);
 
-        errorSpectrum[index] = (d1 * K1[index] + d3 * K3[index] + d4 * K4[index] + d5 * K5[index] + d6 * K6[index]) * step;
+    // Block 7 Calculations -------------------
+    t_int = *t + c7 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a71 * K1[index] + a74 * K4[index] + a75 * K5[index] + a76 * K6[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K7);
+
+    // Block 8 Calculations -------------------
+    t_int = *t + c8 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a81 * K1[index] + a84 * K4[index] + a85 * K5[index] + a86 * K6[index] + a87 * K7[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K8);
+
+    // Block 9 Calculations -------------------
+    t_int = *t + c9 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a91 * K1[index] + a94 * K4[index] + a95 * K5[index] + a96 * K6[index] + a97 * K7[index] + a98 * K8[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K9);
+
+    // Block 10 Calculations ------------------
+    t_int = *t + c10 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a101 * K1[index] + a104 * K4[index] + a105 * K5[index] + a106 * K6[index] + a107 * K7[index]
+                                 + a108 * K8[index] + a109 * K9[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K10);
+
+    // Block 11 Calculations ------------------
+    t_int = *t + c11 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a111 * K1[index] + a114 * K4[index] + a115 * K5[index] + a116 * K6[index] + a117 * K7[index]
+                                 + a118 * K8[index] + a119 * K9[index] + a1110 * K10[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K11);
+
+    // Block 12 Calculations ------------------
+    t_int = *t + step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a121 * K1[index] + a124 * K4[index] + a125 * K5[index] + a126 * K6[index] + a127 * K7[index]
+                                 + a128 * K8[index] + a129 * K9[index] + a1210 * K10[index] + a1211 * K11[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K12);
+
+    // i+1 Increment Step and errors, fused with the error norms in one sweep
+    double slope, weight, ratio3, ratio5, err3, err5, denominator;
+    double sumSquares3 = 0.0, maxRatio3 = 0.0, sumSquares5 = 0.0, maxRatio5 = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        slope = b1 * K1[index] + b6 * K6[index] + b7 * K7[index] + b8 * K8[index] + b9 * K9[index]
+              + b10 * K10[index] + b11 * K11[index] + b12 * K12[index];
+
+        ytemp[index] = y[index] + slope * step;
+
+        weight = errorWeight(norm, index, y[index], ytemp[index]);
+        ratio3 = (slope - bhh1 * K1[index] - bhh2 * K9[index] - bhh3 * K12[index]) * step / weight;
+        ratio5 = (er1 * K1[index] + er6 * K6[index] + er7 * K7[index] + er8 * K8[index] + er9 * K9[index]
+                + er10 * K10[index] + er11 * K11[index] + er12 * K12[index]) * step / weight;
+
+        sumSquares3 += ratio3 * ratio3; maxRatio3 = FMAX(maxRatio3, fabs(ratio3));
+        sumSquares5 += ratio5 * ratio5; maxRatio5 = FMAX(maxRatio5, fabs(ratio5));
+    }
+
+    // err5^2 / sqrt(err5^2 + 0.01 * err3^2) ~ O(h^8), see Hairer, Norsett & Wanner, Sec. II.10
+    err3 = errorReduce(norm, sumSquares3, maxRatio3, NSYS);
+    err5 = errorReduce(norm, sumSquares5, maxRatio5, NSYS);
+    denominator = sqrt(err5 * err5 + 0.01 * err3 * err3);
+
+    return (denominator > 0.0) ? (err5 * err5) / denominator : 0.0;
+}
+
+// Method ID = 12
+// Bogacki-Shampine 3(2) pair: the 3rd order solution is advanced and the 2nd order
+// solution provides the error estimate. The last stage is f(t + h, ytemp) (FSAL), left
+// in K[3 * NSYS] for the first stage of the next step.
+double BogackiShampine32(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        p1 = 0.5, q11 = 0.5,
+        p2 = 0.75, q22 = 0.75,
+        a1 = 2.0/9.0, a2 = 1.0/3.0, a3 = 4.0/9.0,
+        d1 = (2.0/9.0) - (7.0/24.0), d2 = (1.0/3.0) - 0.25, d3 = (4.0/9.0) - (1.0/3.0), d4 = -0.125;
+
+    // --  ------------------------------------------------------------------------
+
+    double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS];
+
+    // Block 1 Calculations: K1 supplied by the caller
+
+    // Block 2 Calculations -------------------
+    t_int = *t + p1 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q11 * K1[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K2);
+
+    // Block 3 Calculations -------------------
+    t_int = *t + p2 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q22 * K2[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K3);
+
+    // i+1 Increment Step, then the FSAL stage at the new point
+    for (int index = 0; index < NSYS; ++index) {
+        ytemp[index] = y[index] + (a1 * K1[index] + a2 * K2[index] + a3 * K3[index]) * step;
+    }
+
+    t_int = *t + step;
+    derivative(&t_int, ytemp, K4);
+
+    // errors
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        ratio = (d1 * K1[index] + d2 * K2[index] + d3 * K3[index] + d4 * K4[index]) * step
+              / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 13
+// Runge-Kutta-Fehlberg 4(5) pair: the 4th order solution is advanced (no local
+// extrapolation) and the 5th order solution provides the error estimate.
+double Fehlberg45(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        p1 = 0.25, q11 = 0.25,
+        p2 = 0.375, q21 = 3.0/32.0, q22 = 9.0/32.0,
+        p3 = 12.0/13.0, q31 = 1932.0/2197.0, q32 = -7200.0/2197.0, q33 = 7296.0/2197.0,
+        p4 = 1.0, q41 = 439.0/216.0, q42 = -8.0, q43 = 3680.0/513.0, q44 = -845.0/4104.0,
+        p5 = 0.5, q51 = -8.0/27.0, q52 = 2.0, q53 = -3544.0/2565.0, q54 = 1859.0/4104.0, q55 = -11.0/40.0,
+        a1 = 25.0/216.0, a3 = 1408.0/2565.0, a4 = 2197.0/4104.0, a5 = -0.2,
+        d1 = (16.0/135.0) - (25.0/216.0), d3 = (6656.0/12825.0) - (1408.0/2565.0),
+        d4 = (28561.0/56430.0) - (2197.0/4104.0), d5 = -(9.0/50.0) + 0.2, d6 = 2.0/55.0;
+
+    // --  ------------------------------------------------------------------------
+
+    double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS],
+           *K5 = &K[4 * NSYS], *K6 = &K[5 * NSYS];
+
+    // Block 1 Calculations: K1 supplied by the caller
+
+    // Block 2 Calculations -------------------
+    t_int = *t + p1 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q11 * K1[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K2);
+
+    // Block 3 Calculations -------------------
+    t_int = *t + p2 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q21 * K1[index] + q22 * K2[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K3);
+
+    // Block 4 Calculations -------------------
+    t_int = *t + p3 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q31 * K1[index] + q32 * K2[index] + q33 * K3[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K4);
+
+    // Block 5 Calculations -------------------
+    t_int = *t + p4 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q41 * K1[index] + q42 * K2[index] + q43 * K3[index] + q44 * K4[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K5);
+
+    // Block 6 Calculations -------------------
+    t_int = *t + p5 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (q51 * K1[index] + q52 * K2[index] + q53 * K3[index] + q54 * K4[index] + q55 * K5[index]) * step;
     }
 
+    derivative(&t_int, y_int, K6);
+
+    // i+1 Increment Step and errors, fused with the error norm in one sweep
+    double slope, ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        slope = a1 * K1[index] + a3 * K3[index] + a4 * K4[index] + a5 * K5[index];
+
+        ytemp[index] = y[index] + slope * step;
+
+        ratio = (d1 * K1[index] + d3 * K3[index] + d4 * K4[index] + d5 * K5[index] + d6 * K6[index]) * step
+              / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 2, adaptive
+// Heun-Euler 2(1) pair: Heun's method (single corrector) is advanced and the forward
+// Euler solution provides the error estimate.
+double HeunEuler21(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int NSYS){
+
+    double t_int, y_int[NSYS];
+    double *K1 = &K[0], *K2 = &K[NSYS];
+
+    // Block 1 Calculations: K1 supplied by the caller
+
+    // Block 2 Calculations -------------------
+    t_int = *t + step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + K1[index] * step; // Euler predictor
+    }
+
+    derivative(&t_int, y_int, K2);
+
+    // i+1 Increment Step and errors, fused with the error norm in one sweep
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        ytemp[index] = y[index] + 0.5 * (K1[index] + K2[index]) * step;
+
+        ratio = 0.5 * (K2[index] - K1[index]) * step / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 1, 3-8, adaptive
+// Richardson step doubling around any fixed stepsize method of order p: one step of
+// size h and two of size h/2. The two half steps are advanced and their error is
+// estimated as (y_half - y_full)/(2^p - 1), so the method keeps its own tableau.
+double Richardson(void (*method)(void (*)(const double *, const double [], double []), double *, double [], double, int), int order, void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, int NSYS){
+
+    double t_full = *t, y_full[NSYS], t_half = *t;
+    double denominator = pow(2.0, order) - 1.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        y_full[index] = y[index];
+        ytemp[index] = y[index];
+    }
+
+    method(derivative, &t_full, y_full, step, NSYS);
+    method(derivative, &t_half, ytemp, 0.5 * step, NSYS);
+    method(derivative, &t_half, ytemp, 0.5 * step, NSYS);
+
+    // errors
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        ratio = (ytemp[index] - y_full[index]) / denominator / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Method ID = 15
+// Runge-Kutta-Chebyshev (Sommeijer, Shampine & Verwer): s-stage damped Chebyshev method of
+// order 2 whose real stability interval grows like 0.65 * s^2, for mildly stiff problems with
+// a known spectral radius. K[0] holds f(t, y) from the caller and K[NSYS..2 * NSYS) receives
+// f(t + h, ytemp) (FSAL), needed by the error estimate; two more state vectors on the stack.
+double RKC(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, double K[], int s, int NSYS){
+
+    double yjm1_buf[NSYS], yjm2_buf[NSYS];
+    double *yjm1 = yjm1_buf, *yjm2 = yjm2_buf, *yj = ytemp, *swap, *fj = &K[NSYS];
+    double w0 = 1.0 + 2.0/(13.0 * s * s), temp1 = w0 * w0 - 1.0, temp2 = sqrt(temp1);
+    double arg = s * log(w0 + temp2);
+    double w1 = sinh(arg) * temp1 / (cosh(arg) * s * temp2 - w0 * sinh(arg));
+    double bjm1 = 1.0/(4.0 * w0 * w0), bjm2 = bjm1, bj, ajm1, mu, nu, mus;
+    double zjm1 = w0, zjm2 = 1.0, dzjm1 = 1.0, dzjm2 = 0.0, d2zjm1 = 0.0, d2zjm2 = 0.0, zj, dzj, d2zj;
+    double thjm1, thjm2 = 0.0, thj, t_stage;
+
+    // Block 1 Calculations: K1 supplied by the caller
+    mus = w1 * bjm1;
+    thjm1 = mus;
+    for (int index = 0; index < NSYS; ++index) {
+        yjm2[index] = y[index];
+        yjm1[index] = y[index] + step * mus * K[index];
+    }
+
+    // Block 2..s Calculations: three term Chebyshev recursion
+    for (int j = 2; j <= s; ++j) {
+        zj = 2.0 * w0 * zjm1 - zjm2;
+        dzj = 2.0 * w0 * dzjm1 - dzjm2 + 2.0 * zjm1;
+        d2zj = 2.0 * w0 * d2zjm1 - d2zjm2 + 4.0 * dzjm1;
+        bj = d2zj / (dzj * dzj);
+        ajm1 = 1.0 - zjm1 * bjm1;
+        mu = 2.0 * w0 * bj / bjm1;
+        nu = -bj / bjm2;
+        mus = mu * w1 / w0;
+
+        t_stage = *t + step * thjm1;
+        derivative(&t_stage, yjm1, fj);
+
+        for (int index = 0; index < NSYS; ++index) {
+            yj[index] = mu * yjm1[index] + nu * yjm2[index] + (1.0 - mu - nu) * y[index]
+                      + step * mus * (fj[index] - ajm1 * K[index]);
+        }
+        thj = mu * thjm1 + nu * thjm2 + mus * (1.0 - ajm1);
+
+        // shift the recursion, yj takes the buffer of Y(j - 2)
+        swap = yjm2; yjm2 = yjm1; yjm1 = yj; yj = swap;
+        thjm2 = thjm1; thjm1 = thj;
+        bjm2 = bjm1; bjm1 = bj;
+        zjm2 = zjm1; zjm1 = zj;
+        dzjm2 = dzjm1; dzjm1 = dzj;
+        d2zjm2 = d2zjm1; d2zjm1 = d2zj;
+    }
+
+    for (int index = 0; yjm1 != ytemp && index < NSYS; ++index) {
+        ytemp[index] = yjm1[index];
+    }
+
+    t_stage = *t + step;
+    derivative(&t_stage, ytemp, fj);
+
+    // errors
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        ratio = (0.8 * (y[index] - ytemp[index]) + 0.4 * step * (K[index] + fj[index]))
+              / errorWeight(norm, index, y[index], ytemp[index]);
+
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// Stages for a RKC step of size step: the smallest s with h * spectralRadius inside the
+// stability interval (with a margin), at least 2 and at most RKC_MAXSTAGES.
+int RKC_stages(double step, double spectralRadius){
+
+    int s = 1 + (int) sqrt(1.0 + 1.54 * fabs(step) * spectralRadius);
+
+    return (s < 2) ? 2 : ((s > RKC_MAXSTAGES) ? RKC_MAXSTAGES : s);
+}
+
+// Nonlinear power iteration for the spectral radius of the Jacobian at (t, y), with dydt = f(t, y).
+// v[] holds the starting direction (the last one found, or dydt) and returns the new one.
+// The estimate carries a 20% safety margin. *calls counts the derivative evaluations.
+double spectralRadius(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], double v[], int *calls, int NSYS){
+
+    static int maxIter = 50;
+    double uround = 2.2e-16, sqrtu = sqrt(uround);
+    double ynrm = 0.0, vnrm = 0.0, dynrm, dfnrm, sigma = 0.0, sigmal;
+    double z[NSYS], fz[NSYS];
+
+    for (int index = 0; index < NSYS; ++index) {
+        ynrm += y[index] * y[index];
+        vnrm += v[index] * v[index];
+    }
+    ynrm = sqrt(ynrm); vnrm = sqrt(vnrm);
+
+    // perturbation of relative size sqrt(uround) along v
+    dynrm = (ynrm != 0.0) ? ynrm * sqrtu : uround;
+    for (int index = 0; index < NSYS; ++index) {
+        if(vnrm != 0.0) {
+            z[index] = y[index] + v[index] * (dynrm / vnrm);
+        } else {
+            z[index] = (ynrm != 0.0) ? y[index] * (1.0 + sqrtu) : dynrm;
+        }
+    }
+
+    for (int iter = 1; iter <= maxIter; ++iter) {
+
+        derivative(t, z, fz);
+        *calls += 1;
+
+        dfnrm = 0.0;
+        for (int index = 0; index < NSYS; ++index) {
+            dfnrm += (fz[index] - dydt[index]) * (fz[index] - dydt[index]);
+        }
+        dfnrm = sqrt(dfnrm);
+
+        sigmal = sigma;
+        sigma = dfnrm / dynrm;
+
+        if(iter >= 2 && fabs(sigma - sigmal) <= FMAX(sigma, 1.0e-30) * 0.01) {
+            break;
+        }
+
+        if(dfnrm != 0.0) {
+            for (int index = 0; index < NSYS; ++index) {
+                z[index] = y[index] + (fz[index] - dydt[index]) * (dynrm / dfnrm);
+            }
+        } else {
+            int index = iter % NSYS;
+            z[index] = y[index] - (z[index] - y[index]);
+        }
+    }
+
+    for (int index = 0; index < NSYS; ++index) {
+        v[index] = z[index] - y[index];
+    }
+
+    return 1.2 * sigma;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Extrapolation
+//
+// ----------------------------------------------------------------------------
+
+// Method ID = 14 (Gragg-Bulirsch-Stoer)
+// Gragg's modified midpoint rule: the midpoint rule of Method ID = 3 taken as a leapfrog
+// over nsteps substeps, with an Euler start and a final smoothing step. Its error expands
+// in even powers of the substep, so each extrapolation gains two orders. dydt = f(t, y)
+// is supplied by the caller and costs nothing here: nsteps derivative evaluations.
+void ModifiedMidpoint(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], double step, int nsteps, double yout[], int NSYS){
+
+    double h = step / nsteps, t_mid;
+    double z_prev[NSYS], z[NSYS], slope[NSYS], swap;
+
+    for (int index = 0; index < NSYS; ++index) {
+        z_prev[index] = y[index];
+        z[index] = y[index] + h * dydt[index];
+    }
+
+    for (int m = 1; m < nsteps; ++m) {
+        t_mid = *t + m * h;
+        derivative(&t_mid, z, slope);
+
+        for (int index = 0; index < NSYS; ++index) {
+            swap = z_prev[index] + 2.0 * h * slope[index];
+            z_prev[index] = z[index];
+            z[index] = swap;
+        }
+    }
+
+    t_mid = *t + step;
+    derivative(&t_mid, z, slope);
+
+    for (int index = 0; index < NSYS; ++index) {
+        yout[index] = 0.5 * (z_prev[index] + z[index] + h * slope[index]);
+    }
+}
+
+typedef struct _gbsWork {
+    void (*derivative)(const double *t, const double y[], double ydot[]);
+    const double *t, *y, *dydt;
+    double step, *table;
+    int rows[GBS_MAXROWS], count, load, NSYS;
+} gbsWork;
+
+static void * GBS_worker(void *arg){
+
+    gbsWork *work = (gbsWork *) arg;
+
+    for (int i = 0; i < work -> count; ++i) {
+        int row = work -> rows[i];
+        ModifiedMidpoint(work -> derivative, work -> t, work -> y, work -> dydt, work -> step,
+                         GBS_SUBSTEPS(row), &work -> table[row * work -> NSYS], work -> NSYS);
+    }
+
+    return NULL;
+}
+
+// Rows first..last of the extrapolation table: modified midpoint solutions with
+// GBS_SUBSTEPS(row) substeps, row j stored at table[j * NSYS]. With threads > 1 the rows
+// are shared out across POSIX threads, largest first to the least loaded thread, so the
+// derivative function must be safe to call concurrently.
+void GBS_rows(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], double step, int first, int last, double table[], int threads, int NSYS){
+
+    gbsWork work[GBS_MAXROWS];
+    pthread_t thread[GBS_MAXROWS];
+
+    threads = (threads < 1) ? 1 : threads;
+    threads = (threads > last - first + 1) ? last - first + 1 : threads;
+
+    for (int i = 0; i < threads; ++i) {
+        work[i] = (gbsWork) { .derivative = derivative, .t = t, .y = y, .dydt = dydt, .step = step,
+                              .table = table, .count = 0, .load = 0, .NSYS = NSYS };
+    }
+
+    for (int row = last; row >= first; --row) {
+        int least = 0;
+        for (int i = 1; i < threads; ++i) {
+            least = (work[i].load < work[least].load) ? i : least;
+        }
+        work[least].rows[work[least].count++] = row;
+        work[least].load += GBS_SUBSTEPS(row);
+    }
+
+    // the calling thread takes the first share
+    for (int i = 1; i < threads; ++i) {
+        if(pthread_create(&thread[i], NULL, GBS_worker, &work[i]) != 0) {
+            GBS_worker(&work[i]);
+            work[i].count = -1; // not joined
+        }
+    }
+
+    GBS_worker(&work[0]);
+
+    for (int i = 1; i < threads; ++i) {
+        if(work[i].count >= 0) {
+            pthread_join(thread[i], NULL);
+        }
+    }
+}
+
+// Aitken-Neville sweep for row `row`, whose midpoint solution is in table[row * NSYS].
+// Afterwards table[0] holds the extrapolated solution of order 2 * (row + 1), copied to
+// yout, and the norm of its difference to the next lower order, table[0] - table[1],
+// is returned as the error signal.
+double GBS_extrapolate(int row, double table[], const double y[], double yout[], const errorNorm *norm, int NSYS){
+
+    double ratio;
+
+    for (int l = row; l > 0; --l) {
+        ratio = (double) GBS_SUBSTEPS(row) / GBS_SUBSTEPS(l - 1);
+        ratio = ratio * ratio - 1.0;
+
+        for (int index = 0; index < NSYS; ++index) {
+            table[(l - 1) * NSYS + index] = table[l * NSYS + index]
+                + (table[l * NSYS + index] - table[(l - 1) * NSYS + index]) / ratio;
+        }
+    }
+
+    // errors
+    double sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        yout[index] = table[index];
+
+        if(row > 0) {
+            ratio = (table[index] - table[NSYS + index]) / errorWeight(norm, index, y[index], yout[index]);
+
+            sumSquares += ratio * ratio;
+            maxRatio = FMAX(maxRatio, fabs(ratio));
+        }
+    }
+
+    return errorReduce(norm, sumSquares, maxRatio, NSYS);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Dense Output
+//
+// ----------------------------------------------------------------------------
+
+// Each *_contd() is called once a step from t to t + step has been accepted and
+// fills cont[] with the coefficients of a continuous extension over that step.
+// The interpolants are then evaluated at theta = (t_out - t)/step in [0, 1].
+// The caller supplies f(t + step, ytemp), which is also the first stage of the next step.
+
+// Cubic Hermite interpolant from the end point values and slopes, 3rd order.
+// Used by the pairs without a dedicated interpolant; cont[] needs 4 * NSYS entries.
+void Hermite_contd(const double y[], const double ytemp[], const double dydt[], const double dydt_new[], double step, double cont[], int NSYS){
+
+    double ydiff;
+
+    for (int index = 0; index < NSYS; ++index) {
+        ydiff = ytemp[index] - y[index];
+
+        cont[index] = y[index];
+        cont[NSYS + index] = step * dydt[index];
+        cont[2 * NSYS + index] = 3.0 * ydiff - step * (2.0 * dydt[index] + dydt_new[index]);
+        cont[3 * NSYS + index] = -2.0 * ydiff + step * (dydt[index] + dydt_new[index]);
+    }
+}
+
+// 4th order continuous extension of Verner65 that uses f(t + h, ytemp) as a ninth
+// stage, in K[8 * NSYS]. It matches y and y' at both ends of the step.
+// cont[] needs 5 * NSYS entries.
+void Verner65_contd(const double y[], double step, double K[], double cont[], int NSYS){
+
+    // -- Parameters: b_i(theta) = sum_k r_ki theta^k, r_1i = delta_1i ------------
+    static double
+        r21 = -519.0/160.0, r23 = 68125.0/17952.0, r24 = -77.0/144.0, r25 = -2028.0/1955.0,
+        r26 = -45.0/44.0, r27 = 3875.0/11592.0, r28 = 129.0/616.0, r29 = 1.5,
+        r31 = 303.0/80.0, r33 = -54125.0/8976.0, r34 = 169.0/72.0, r35 = 5112.0/1955.0,
+        r36 = 45.0/22.0, r37 = -3625.0/5796.0, r38 = -43.0/308.0, r39 = -4.0,
+        r41 = -47.0/32.0, r43 = 47125.0/17952.0, r44 = -215.0/144.0, r45 = -564.0/391.0,
+        r46 = -45.0/44.0, r47 = 125.0/414.0, r49 = 2.5;
+
+    // --  ------------------------------------------------------------------------
+
+    double *K1 = &K[0], *K3 = &K[2 * NSYS], *K4 = &K[3 * NSYS], *K5 = &K[4 * NSYS],
+           *K6 = &K[5 * NSYS], *K7 = &K[6 * NSYS], *K8 = &K[7 * NSYS], *K9 = &K[8 * NSYS];
+
+    for (int index = 0; index < NSYS; ++index) {
+        cont[index] = y[index];
+        cont[NSYS + index] = step * K1[index];
+        cont[2 * NSYS + index] = step * (r21 * K1[index] + r23 * K3[index] + r24 * K4[index] + r25 * K5[index]
+                                       + r26 * K6[index] + r27 * K7[index] + r28 * K8[index] + r29 * K9[index]);
+        cont[3 * NSYS + index] = step * (r31 * K1[index] + r33 * K3[index] + r34 * K4[index] + r35 * K5[index]
+                                       + r36 * K6[index] + r37 * K7[index] + r38 * K8[index] + r39 * K9[index]);
+        cont[4 * NSYS + index] = step * (r41 * K1[index] + r43 * K3[index] + r44 * K4[index] + r45 * K5[index]
+                                       + r46 * K6[index] + r47 * K7[index] + r49 * K9[index]);
+    }
+}
+
+// Evaluates the polynomial interpolants of Hermite_contd (degree 3) and
+// Verner65_contd (degree 4) by Horner's rule.
+void polynomial_dense(double theta, const double cont[], int degree, double yout[], int NSYS){
+
+    for (int index = 0; index < NSYS; ++index) {
+        yout[index] = cont[degree * NSYS + index];
+        for (int power = degree - 1; power >= 0; --power) {
+            yout[index] = yout[index] * theta + cont[power * NSYS + index];
+        }
+    }
+}
+
+// Derivative d/dtheta of polynomial_dense, by Horner's rule.
+void polynomial_slope(double theta, const double cont[], int degree, double slope[], int NSYS){
+
+    for (int index = 0; index < NSYS; ++index) {
+        slope[index] = degree * cont[degree * NSYS + index];
+        for (int power = degree - 1; power >= 1; --power) {
+            slope[index] = slope[index] * theta + power * cont[power * NSYS + index];
+        }
+    }
+}
+
+// 7th order dense output of DOP853: f(t + h, ytemp) in K[12 * NSYS] is the 13th stage
+// and three extra stages go to K[13..15 * NSYS]. cont[] needs 8 * NSYS entries.
+void DOP853_contd(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double ytemp[], double step, double K[], double cont[], int NSYS){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        c14 = 0.1, c15 = 0.2, c16 = 0.777777777777777777777777777778,
+
+        a141 = 5.61675022830479523392909219681e-2, a147 = 2.53500210216624811088794765333e-1, a148 = -2.46239037470802489917441475441e-1,
+        a149 = -1.24191423263816360469010140626e-1, a1410 = 1.5329179827876569731206322685e-1, a1411 = 8.20105229563468988491666602057e-3,
+        a1412 = 7.56789766054569976138603589584e-3, a1413 = -8.298e-3,
+        a151 = 3.18346481635021405060768473261e-2, a156 = 2.83009096723667755288322961402e-2, a157 = 5.35419883074385676223797384372e-2,
+        a158 = -5.49237485713909884646569340306e-2, a1511 = -1.08347328697249322858509316994e-4, a1512 = 3.82571090835658412954920192323e-4,
+        a1513 = -3.40465008687404560802977114492e-4, a1514 = 1.41312443674632500278074618366e-1,
+        a161 = -4.28896301583791923408573538692e-1, a166 = -4.69762141536116384314449447206, a167 = 7.68342119606259904184240953878,
+        a168 = 4.06898981839711007970213554331, a169 = 3.56727187455281109270669543021e-1, a1613 = -1.39902416515901462129418009734e-3,
+        a1614 = 2.9475147891527723389556272149, a1615 = -9.15095847217987001081870187138,
+
+        d41 = -0.84289382761090128651353491142e+01, d46 = 0.56671495351937776962531783590, d47 = -0.30689499459498916912797304727e+01,
+        d48 = 0.23846676565120698287728149680e+01, d49 = 0.21170345824450282767155149946e+01, d410 = -0.87139158377797299206789907490,
+        d411 = 0.22404374302607882758541771650e+01, d412 = 0.63157877876946881815570249290, d413 = -0.88990336451333310820698117400e-01,
+        d414 = 0.18148505520854727256656404962e+02, d415 = -0.91946323924783554000451984436e+01, d416 = -0.44360363875948939664310572000e+01,
+        d51 = 0.10427508642579134603413151009e+02, d56 = 0.24228349177525818288430175319e+03, d57 = 0.16520045171727028198505394887e+03,
+        d58 = -0.37454675472269020279518312152e+03, d59 = -0.22113666853125306036270938578e+02, d510 = 0.77334326684722638389603898808e+01,
+        d511 = -0.30674084731089398182061213626e+02, d512 = -0.93321305264302278729567221706e+01, d513 = 0.15697238121770843886131091075e+02,
+        d514 = -0.31139403219565177677282850411e+02, d515 = -0.93529243588444783865713862664e+01, d516 = 0.35816841486394083752465898540e+02,
+        d61 = 0.19985053242002433820987653617e+02, d66 = -0.38703730874935176555105901742e+03, d67 = -0.18917813819516756882830838328e+03,
+        d68 = 0.52780815920542364900561016686e+03, d69 = -0.11573902539959630126141871134e+02, d610 = 0.68812326946963000169666922661e+01,
+        d611 = -0.10006050966910838403183860980e+01, d612 = 0.77771377980534432092869265740, d613 = -0.27782057523535084065932004339e+01,
+        d614 = -0.60196695231264120758267380846e+02, d615 = 0.84320405506677161018159903784e+02, d616 = 0.11992291136182789328035130030e+02,
+        d71 = -0.25693933462703749003312586129e+02, d76 = -0.15418974869023643374053993627e+03, d77 = -0.23152937917604549567536039109e+03,
+        d78 = 0.35763911791061412378285349910e+03, d79 = 0.93405324183624310003907691704e+02, d710 = -0.37458323136451633156875139351e+02,
+        d711 = 0.10409964950896230045147246184e+03, d712 = 0.29840293426660503123344363579e+02, d713 = -0.43533456590011143754432175058e+02,
+        d714 = 0.96324553959188282948394950600e+02, d715 = -0.39177261675615439165231486172e+02, d716 = -0.14972683625798562581422125276e+03;
+
+    // --  ------------------------------------------------------------------------
+
+    double t_int, y_int[NSYS], ydiff, bspl;
+    double *K1 = &K[0], *K6 = &K[5 * NSYS], *K7 = &K[6 * NSYS], *K8 = &K[7 * NSYS],
+           *K9 = &K[8 * NSYS], *K10 = &K[9 * NSYS], *K11 = &K[10 * NSYS], *K12 = &K[11 * NSYS],
+           *K13 = &K[12 * NSYS], *K14 = &K[13 * NSYS], *K15 = &K[14 * NSYS], *K16 = &K[15 * NSYS];
+
+    // Block 13 Calculations: f(t + h, ytemp) supplied by the caller
+
+    // Block 14 Calculations ------------------
+    t_int = *t + c14 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a141 * K1[index] + a147 * K7[index] + a148 * K8[index] + a149 * K9[index]
+                                 + a1410 * K10[index] + a1411 * K11[index] + a1412 * K12[index] + a1413 * K13[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K14);
+
+    // Block 15 Calculations ------------------
+    t_int = *t + c15 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a151 * K1[index] + a156 * K6[index] + a157 * K7[index] + a158 * K8[index]
+                                 + a1511 * K11[index] + a1512 * K12[index] + a1513 * K13[index] + a1514 * K14[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K15);
+
+    // Block 16 Calculations ------------------
+    t_int = *t + c16 * step;
+    for (int index = 0; index < NSYS; ++index) {
+        y_int[index] = y[index] + (a161 * K1[index] + a166 * K6[index] + a167 * K7[index] + a168 * K8[index]
+                                 + a169 * K9[index] + a1613 * K13[index] + a1614 * K14[index] + a1615 * K15[index]) * step;
+    }
+
+    derivative(&t_int, y_int, K16);
+
+    // Continuous extension coefficients
+    for (int index = 0; index < NSYS; ++index) {
+        ydiff = ytemp[index] - y[index];
+        bspl = step * K1[index] - ydiff;
+
+        cont[index] = y[index];
+        cont[NSYS + index] = ydiff;
+        cont[2 * NSYS + index] = bspl;
+        cont[3 * NSYS + index] = ydiff - step * K13[index] - bspl;
+        cont[4 * NSYS + index] = step * (d41 * K1[index] + d46 * K6[index] + d47 * K7[index] + d48 * K8[index] + d49 * K9[index] + d410 * K10[index]
+                                       + d411 * K11[index] + d412 * K12[index] + d413 * K13[index] + d414 * K14[index] + d415 * K15[index] + d416 * K16[index]);
+        cont[5 * NSYS + index] = step * (d51 * K1[index] + d56 * K6[index] + d57 * K7[index] + d58 * K8[index] + d59 * K9[index] + d510 * K10[index]
+                                       + d511 * K11[index] + d512 * K12[index] + d513 * K13[index] + d514 * K14[index] + d515 * K15[index] + d516 * K16[index]);
+        cont[6 * NSYS + index] = step * (d61 * K1[index] + d66 * K6[index] + d67 * K7[index] + d68 * K8[index] + d69 * K9[index] + d610 * K10[index]
+                                       + d611 * K11[index] + d612 * K12[index] + d613 * K13[index] + d614 * K14[index] + d615 * K15[index] + d616 * K16[index]);
+        cont[7 * NSYS + index] = step * (d71 * K1[index] + d76 * K6[index] + d77 * K7[index] + d78 * K8[index] + d79 * K9[index] + d710 * K10[index]
+                                       + d711 * K11[index] + d712 * K12[index] + d713 * K13[index] + d714 * K14[index] + d715 * K15[index] + d716 * K16[index]);
+    }
+}
+
+void DOP853_dense(double theta, const double cont[], double yout[], int NSYS){
+
+    double theta1 = 1.0 - theta, conpar;
+
+    for (int index = 0; index < NSYS; ++index) {
+        conpar = cont[4 * NSYS + index] + theta * (cont[5 * NSYS + index] + theta1 * (cont[6 * NSYS + index] + theta * cont[7 * NSYS + index]));
+        yout[index] = cont[index] + theta * (cont[NSYS + index] + theta1 * (cont[2 * NSYS + index] + theta * (cont[3 * NSYS + index] + theta1 * conpar)));
+    }
+}
+
+// Derivative d/dtheta of DOP853_dense, the nested products differentiated from the inside out.
+void DOP853_slope(double theta, const double cont[], double slope[], int NSYS){
+
+    double theta1 = 1.0 - theta, inner, dinner, conpar, dconpar, outer, douter;
+
+    for (int index = 0; index < NSYS; ++index) {
+        inner = cont[5 * NSYS + index] + theta1 * (cont[6 * NSYS + index] + theta * cont[7 * NSYS + index]);
+        dinner = - (cont[6 * NSYS + index] + theta * cont[7 * NSYS + index]) + theta1 * cont[7 * NSYS + index];
+        conpar = cont[4 * NSYS + index] + theta * inner;
+        dconpar = inner + theta * dinner;
+        outer = cont[3 * NSYS + index] + theta1 * conpar;
+        douter = - conpar + theta1 * dconpar;
+        inner = cont[2 * NSYS + index] + theta * outer;
+        dinner = outer + theta * douter;
+        outer = cont[NSYS + index] + theta1 * inner;
+        douter = - inner + theta1 * dinner;
+        slope[index] = outer + theta * douter;
+    }
 }
 
 // ----------------------------------------------------------------------------
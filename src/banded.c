@@ -0,0 +1,275 @@
+/*
+* Band matrices: storage by rows of the band, products, conversion to the dense
+* matrices of the implicit methods and LU decomposition with partial pivoting, in
+* double or single precision.
+*/
+
+#include "banded.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ----------------------------------------------------------------------------
+//
+//                            Band Matrices
+//
+// ----------------------------------------------------------------------------
+
+bandMatrix * bandAlloc(int n, int lower, int upper){
+
+    bandMatrix *A = (bandMatrix *) malloc(sizeof(bandMatrix));
+
+    A -> n = n;
+    A -> lower = lower;
+    A -> upper = upper;
+    A -> width = lower + upper + 1;
+    A -> data = (double *) calloc((size_t) n * A -> width, sizeof(double));
+
+    return A;
+}
+
+void bandFree(bandMatrix *A){
+
+    if(A == NULL) {
+        return;
+    }
+
+    free(A -> data);
+    free(A);
+}
+
+void bandZero(bandMatrix *A){
+
+    memset(A -> data, 0, sizeof(double) * (size_t) A -> n * A -> width);
+}
+
+// adds value at (row, col), dropped outside the band
+void bandAdd(bandMatrix *A, int row, int col, double value){
+
+    if(col - row > A -> upper || row - col > A -> lower || col < 0 || col >= A -> n) {
+        return;
+    }
+
+    BAND(A, row, col) += value;
+}
+
+// out = A x
+void bandMultiply(const bandMatrix *A, const double x[], double out[]){
+
+    for (int row = 0; row < A -> n; ++row) {
+        int first = (row - A -> lower > 0) ? row - A -> lower : 0;
+        int last = (row + A -> upper < A -> n - 1) ? row + A -> upper : A -> n - 1;
+        double sum = 0.0;
+        for (int col = first; col <= last; ++col) {
+            sum += BAND(A, row, col) * x[col];
+        }
+        out[row] = sum;
+    }
+}
+
+void bandToDense(const bandMatrix *A, gsl_matrix *dense){
+
+    gsl_matrix_set_zero(dense);
+
+    for (int row = 0; row < A -> n; ++row) {
+        int first = (row - A -> lower > 0) ? row - A -> lower : 0;
+        int last = (row + A -> upper < A -> n - 1) ? row + A -> upper : A -> n - 1;
+        for (int col = first; col <= last; ++col) {
+            gsl_matrix_set(dense, row, col, BAND(A, row, col));
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Banded LU
+//
+// ----------------------------------------------------------------------------
+
+// LU decomposition with partial pivoting in place, as LINPACK dgbfa: A holds a matrix
+// of bandwidths (lower, upper - lower), the row interchanges fill the other lower
+// superdiagonals. L keeps the multipliers of each column below the diagonal, pivot[k]
+// the row swapped with row k. O(n lower upper) operations. Returns 0, or k + 1 for a
+// zero pivot in column k.
+int bandLU(bandMatrix *A, int pivot[]){
+
+    int n = A -> n, lower = A -> lower, upper = A -> upper;
+
+    for (int k = 0; k < n; ++k) {
+
+        int last = (k + lower < n - 1) ? k + lower : n - 1, lastCol = (k + upper < n - 1) ? k + upper : n - 1;
+        int p = k;
+
+        for (int row = k + 1; row <= last; ++row) {
+            p = (fabs(BAND(A, row, k)) > fabs(BAND(A, p, k))) ? row : p;
+        }
+        pivot[k] = p;
+
+        if(BAND(A, p, k) == 0.0) {
+            return k + 1;
+        }
+
+        if(p != k) {
+            for (int col = k; col <= lastCol; ++col) {
+                double swap = BAND(A, k, col);
+                BAND(A, k, col) = BAND(A, p, col);
+                BAND(A, p, col) = swap;
+            }
+        }
+
+        // a row of the band is contiguous in its columns
+        double inverse = 1.0 / BAND(A, k, k);
+        const double *restrict pivotRow = &BAND(A, k, k + 1);
+        for (int row = k + 1; row <= last; ++row) {
+            double l = BAND(A, row, k) * inverse, *restrict target = &BAND(A, row, k + 1);
+            BAND(A, row, k) = l;
+            if(l == 0.0) {
+                continue;
+            }
+            for (int col = 0; col < lastCol - k; ++col) {
+                target[col] -= l * pivotRow[col];
+            }
+        }
+    }
+
+    return 0;
+}
+
+// solves LU x = b in place with the factors of bandLU()
+void bandSolve(const bandMatrix *LU, const int pivot[], double b[]){
+
+    int n = LU -> n, lower = LU -> lower, upper = LU -> upper;
+
+    // Block 1 Calculations: row interchanges and L, in the order of the elimination
+    for (int k = 0; k < n; ++k) {
+        int last = (k + lower < n - 1) ? k + lower : n - 1;
+        double swap = b[pivot[k]];
+        b[pivot[k]] = b[k];
+        b[k] = swap;
+        for (int row = k + 1; row <= last; ++row) {
+            b[row] -= BAND(LU, row, k) * b[k];
+        }
+    }
+
+    // Block 2 Calculations: U
+    for (int k = n - 1; k >= 0; --k) {
+        int lastCol = (k + upper < n - 1) ? k + upper : n - 1;
+        double sum = b[k];
+        for (int col = k + 1; col <= lastCol; ++col) {
+            sum -= BAND(LU, k, col) * b[col];
+        }
+        b[k] = sum / BAND(LU, k, k);
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Single Precision
+//
+// ----------------------------------------------------------------------------
+
+bandMatrixFloat * bandAllocFloat(int n, int lower, int upper){
+
+    bandMatrixFloat *A = (bandMatrixFloat *) malloc(sizeof(bandMatrixFloat));
+
+    A -> n = n;
+    A -> lower = lower;
+    A -> upper = upper;
+    A -> width = lower + upper + 1;
+    A -> data = (float *) calloc((size_t) n * A -> width, sizeof(float));
+
+    return A;
+}
+
+void bandFreeFloat(bandMatrixFloat *A){
+
+    if(A == NULL) {
+        return;
+    }
+
+    free(A -> data);
+    free(A);
+}
+
+// bandLU() in single precision: half the memory and twice the SIMD width of the double
+// factors, for solves refined against double precision residuals. The fill decays
+// geometrically through the band and its products would reach the subnormal range,
+// where arithmetic is many times slower: multipliers and fill below sqrt(FLT_MIN) are
+// flushed to zero, so no product of two kept entries is subnormal. Scale A to unit
+// size first, which leaves the flushed entries far below single precision resolution.
+int bandLUFloat(bandMatrixFloat *A, int pivot[]){
+
+    int n = A -> n, lower = A -> lower, upper = A -> upper;
+    const float tiny = 1.0842022e-19f; // sqrt(FLT_MIN)
+
+    for (int k = 0; k < n; ++k) {
+
+        int last = (k + lower < n - 1) ? k + lower : n - 1, lastCol = (k + upper < n - 1) ? k + upper : n - 1;
+        int p = k;
+
+        for (int row = k + 1; row <= last; ++row) {
+            p = (fabsf(BAND(A, row, k)) > fabsf(BAND(A, p, k))) ? row : p;
+        }
+        pivot[k] = p;
+
+        if(BAND(A, p, k) == 0.0f) {
+            return k + 1;
+        }
+
+        if(p != k) {
+            for (int col = k; col <= lastCol; ++col) {
+                float swap = BAND(A, k, col);
+                BAND(A, k, col) = BAND(A, p, col);
+                BAND(A, p, col) = swap;
+            }
+        }
+
+        float inverse = 1.0f / BAND(A, k, k);
+        const float *restrict pivotRow = &BAND(A, k, k + 1);
+        for (int row = k + 1; row <= last; ++row) {
+            float l = BAND(A, row, k) * inverse, *restrict target = &BAND(A, row, k + 1);
+            l = (fabsf(l) < tiny) ? 0.0f : l;
+            BAND(A, row, k) = l;
+            if(l == 0.0f) {
+                continue;
+            }
+            for (int col = 0; col < lastCol - k; ++col) {
+                float value = target[col] - l * pivotRow[col];
+                target[col] = (fabsf(value) < tiny) ? 0.0f : value;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// bandSolve() in single precision; b of unit size, entries below sqrt(FLT_MIN) are
+// flushed to zero as in bandLUFloat()
+void bandSolveFloat(const bandMatrixFloat *LU, const int pivot[], float b[]){
+
+    int n = LU -> n, lower = LU -> lower, upper = LU -> upper;
+    const float tiny = 1.0842022e-19f;
+
+    // Block 1 Calculations: row interchanges and L
+    for (int k = 0; k < n; ++k) {
+        int last = (k + lower < n - 1) ? k + lower : n - 1;
+        float swap = b[pivot[k]];
+        b[pivot[k]] = b[k];
+        b[k] = (fabsf(swap) < tiny) ? 0.0f : swap;
+        for (int row = k + 1; b[k] != 0.0f && row <= last; ++row) {
+            b[row] -= BAND(LU, row, k) * b[k];
+        }
+    }
+
+    // Block 2 Calculations: U
+    for (int k = n - 1; k >= 0; --k) {
+        int lastCol = (k + upper < n - 1) ? k + upper : n - 1;
+        float sum = b[k];
+        for (int col = k + 1; col <= lastCol; ++col) {
+            sum -= BAND(LU, k, col) * b[col];
+        }
+        sum /= BAND(LU, k, k);
+        b[k] = (fabsf(sum) < tiny) ? 0.0f : sum;
+    }
+}
@@ -0,0 +1,399 @@
+/*
+* Delay differential equations y'(t) = f(t, y(t), y(t - tau_1), ..., y(t - tau_m)) with
+* constant or state-dependent delays: the lagged values come from the continuous extensions
+* of the accepted steps over the last maximum delay, and before t0 from a history function.
+*/
+
+#include "delay.h"
+#include "implicit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+#define FMIN(x, y) ( x < y ? x : y )
+
+// history of the integration in progress, behind ddeDerivative()
+static ddeHistory *activeHistory = NULL;
+
+// model registered by setDelayModel()
+static void (*delayModel)(const double *t, const double y[], const double ylag[], double ydot[]) = NULL;
+static void (*delayFunction)(const double *t, const double y[], double tau[]) = NULL;
+static void (*historyFunction)(const double *t, double y[]) = NULL;
+static int delayModelDelays = 0;
+
+// ----------------------------------------------------------------------------
+//
+//                            Delay Model
+//
+// ----------------------------------------------------------------------------
+
+// Registers a delay differential equation with delayCount delays. f gets ylag[k * NSYS + i]
+// = y_i(t - tau_k). delays(t, y, tau) fills the state-dependent delays, NULL takes the
+// constant ones of the input file; history(t, y) gives the solution before t0, NULL keeps
+// it at yInitCond.
+void setDelayModel(void (*f)(const double *t, const double y[], const double ylag[], double ydot[]), int delayCount, void (*delays)(const double *t, const double y[], double tau[]), void (*history)(const double *t, double y[])){
+
+    delayModel = f;
+    delayModelDelays = delayCount;
+    delayFunction = delays;
+    historyFunction = history;
+}
+
+bool hasDelayModel(void){
+
+    return delayModel != NULL;
+}
+
+int delayModelCount(void){
+
+    return delayModelDelays;
+}
+
+bool delayModelConstant(void){
+
+    return delayFunction == NULL;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Breakpoints
+//
+// ----------------------------------------------------------------------------
+
+static double breakpointTolerance(double t){
+
+    return 64.0 * DBL_EPSILON * FMAX(fabs(t), 1.0);
+}
+
+// adds a derivative jump of the given level, keeping the list sorted; a jump already
+// listed keeps the lower level
+static void addBreakpoint(ddeHistory *history, double t, int level){
+
+    int index = 0;
+    while(index < history -> breakpointCount && history -> breakpoints[index].t < t - breakpointTolerance(t)) {
+        index += 1;
+    }
+
+    if(index < history -> breakpointCount && fabs(history -> breakpoints[index].t - t) <= breakpointTolerance(t)) {
+        history -> breakpoints[index].level = FMIN(history -> breakpoints[index].level, level);
+        return;
+    }
+
+    if(history -> breakpointCount == history -> breakpointCapacity) {
+        history -> breakpointCapacity *= 2;
+        history -> breakpoints = (ddeBreakpoint *) realloc(history -> breakpoints, sizeof(ddeBreakpoint) * history -> breakpointCapacity);
+    }
+
+    memmove(&history -> breakpoints[index + 1], &history -> breakpoints[index], sizeof(ddeBreakpoint) * (history -> breakpointCount - index));
+    history -> breakpoints[index] = (ddeBreakpoint) { .t = t, .level = level };
+    history -> breakpointCount += 1;
+}
+
+// With constant delays the jumps are known in advance: t0 + tau_k carries the jump of
+// t0 one level up, and so on to maxLevel. Their number is bounded by the levels, not
+// by the domain.
+static void constantBreakpoints(ddeHistory *history, double tEnd){
+
+    for (int index = 0; index < history -> breakpointCount; ++index) {
+        ddeBreakpoint source = history -> breakpoints[index];
+        if(source.level >= history -> maxLevel) {
+            continue;
+        }
+        for (int k = 0; k < history -> delayCount; ++k) {
+            double t = source.t + history -> delays[k];
+            if(history -> delays[k] > 0.0 && t < tEnd) {
+                addBreakpoint(history, t, source.level + 1);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            History
+//
+// ----------------------------------------------------------------------------
+
+ddeHistory * ddeAlloc(odeOptions *options){
+
+    int NSYS = options -> NSYS;
+    ddeHistory *history = (ddeHistory *) malloc(sizeof(ddeHistory));
+
+    history -> NSYS = NSYS;
+    history -> methodId = options -> methodId;
+    history -> contSize = ((options -> methodId == 11) ? 8 : ((options -> methodId == 10) ? 5 : 4)) * NSYS;
+    history -> contOrder = (options -> methodId == 11) ? 7 : ((options -> methodId == 10) ? 4 : 3);
+    history -> delayCount = options -> delayCount;
+    history -> delays = delayModelConstant() ? options -> delays : NULL;
+    history -> maxDelay = options -> maxDelay;
+    history -> t0 = options -> domain[0];
+    history -> y0 = (double *) malloc(sizeof(double) * NSYS);
+    for (int var = 0; var < NSYS; ++var) {
+        history -> y0[var] = options -> yInitCond[var];
+    }
+
+    history -> capacity = DDE_SEGMENTS; history -> head = 0; history -> count = 0;
+    history -> tStart = (double *) malloc(sizeof(double) * DDE_SEGMENTS);
+    history -> step = (double *) malloc(sizeof(double) * DDE_SEGMENTS);
+    history -> cont = (double *) malloc(sizeof(double) * history -> contSize * DDE_SEGMENTS);
+
+    // a jump of order p + 1 no longer disturbs a method of order p
+    history -> maxLevel = FMIN(options -> order + 1, DDE_MAXLEVEL);
+    history -> breakpointCapacity = 16; history -> breakpointCount = 0;
+    history -> breakpoints = (ddeBreakpoint *) malloc(sizeof(ddeBreakpoint) * history -> breakpointCapacity);
+    addBreakpoint(history, history -> t0, 0);
+    if(history -> delays != NULL) {
+        constantBreakpoints(history, options -> domain[1]);
+    }
+
+    activeHistory = history;
+
+    return history;
+}
+
+void ddeFree(ddeHistory *history){
+
+    if(history == NULL) {
+        return;
+    }
+
+    free(history -> y0);
+    free(history -> tStart);
+    free(history -> step);
+    free(history -> cont);
+    free(history -> breakpoints);
+    if(activeHistory == history) {
+        activeHistory = NULL;
+    }
+    free(history);
+}
+
+// ring buffer slot of the index-th oldest segment
+static int segmentSlot(const ddeHistory *history, int index){
+
+    return (history -> head + index) % history -> capacity;
+}
+
+// continuous extension of the method, as in denseInterpolate()
+static void segmentDense(const ddeHistory *history, double theta, const double cont[], double yout[]){
+
+    switch(history -> methodId) {
+        case 10: polynomial_dense(theta, cont, 4, yout, history -> NSYS); break;
+        case 11: DOP853_dense(theta, cont, yout, history -> NSYS); break;
+        case 16: Radau_dense(theta, cont, yout, history -> NSYS); break;
+        default: polynomial_dense(theta, cont, 3, yout, history -> NSYS); break;
+    }
+}
+
+// Solution at s into ylag: the history function before t0, else the interpolant of the
+// step covering s. Beyond the last accepted step, inside the step being taken when a
+// delay is shorter than the stepsize, the last interpolant is extrapolated.
+void ddeLag(const ddeHistory *history, double s, double ylag[]){
+
+    int NSYS = history -> NSYS;
+
+    if(s < history -> t0) {
+        if(historyFunction != NULL) {
+            historyFunction(&s, ylag);
+        } else {
+            memcpy(ylag, history -> y0, sizeof(double) * NSYS);
+        }
+        return;
+    }
+
+    if(history -> count == 0) {
+        memcpy(ylag, history -> y0, sizeof(double) * NSYS);
+        return;
+    }
+
+    if(s < history -> tStart[history -> head]) {
+        fprintf(stderr, "Lag at t = %lf reaches behind the stored history, raise maxDelay. Exiting program..\n", s);
+        exit(EXIT_FAILURE);
+    }
+
+    // last segment starting at or before s
+    int low = 0, high = history -> count - 1;
+    while(low < high) {
+        int mid = (low + high + 1) / 2;
+        if(history -> tStart[segmentSlot(history, mid)] <= s) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    int slot = segmentSlot(history, low);
+    segmentDense(history, (s - history -> tStart[slot]) / history -> step[slot], &history -> cont[history -> contSize * slot], ylag);
+}
+
+static void delaysAt(const ddeHistory *history, const double *t, const double y[], double tau[]){
+
+    if(history -> delays != NULL) {
+        memcpy(tau, history -> delays, sizeof(double) * history -> delayCount);
+        return;
+    }
+
+    delayFunction(t, y, tau);
+    for (int k = 0; k < history -> delayCount; ++k) {
+        if(tau[k] < 0.0 || tau[k] > history -> maxDelay) {
+            fprintf(stderr, "Delay %d is %lf at t = %lf, outside [0, maxDelay]. Exiting program..\n", k, tau[k], *t);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// right hand side of the registered delay model, in the form the steppers call
+void ddeDerivative(const double *t, const double y[], double ydot[]){
+
+    ddeHistory *history = activeHistory;
+    int NSYS = history -> NSYS, delayCount = history -> delayCount;
+    double tau[delayCount], ylag[delayCount * NSYS];
+
+    delaysAt(history, t, y, tau);
+    for (int k = 0; k < delayCount; ++k) {
+        ddeLag(history, *t - tau[k], &ylag[k * NSYS]);
+    }
+
+    delayModel(t, y, ylag, ydot);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Stepping
+//
+// ----------------------------------------------------------------------------
+
+// Trial stepsize from t cut to land on the next derivative jump. State-dependent jumps
+// are predicted from the lag arguments t - tau(t, y) at both ends of the step, the
+// solution at t + h extrapolated from the last interpolant.
+double ddeLimitStep(ddeHistory *history, double t, const double y[], double h){
+
+    double eps = breakpointTolerance(t);
+
+    if(history -> delays != NULL) {
+        for (int index = 0; index < history -> breakpointCount; ++index) {
+            double tb = history -> breakpoints[index].t;
+            if(tb > t + eps) {
+                return (t + h > tb) ? tb - t : h;
+            }
+        }
+        return h;
+    }
+
+    int NSYS = history -> NSYS, delayCount = history -> delayCount;
+    double t1 = t + h, y1[NSYS], tau0[delayCount], tau1[delayCount], hcut = h;
+
+    ddeLag(history, t1, y1);
+    if(history -> count == 0) {
+        memcpy(y1, y, sizeof(double) * NSYS);
+    }
+    delaysAt(history, &t, y, tau0);
+    delaysAt(history, &t1, y1, tau1);
+
+    for (int k = 0; k < delayCount; ++k) {
+        double alpha0 = t - tau0[k], alpha1 = t1 - tau1[k];
+        for (int index = 0; index < history -> breakpointCount; ++index) {
+            double tb = history -> breakpoints[index].t;
+            if(history -> breakpoints[index].level >= history -> maxLevel || alpha0 >= tb - eps || alpha1 < tb) {
+                continue;
+            }
+            // a crossing predicted right at the start was landed on up to the prediction error
+            double tc = t + h * (tb - alpha0) / (alpha1 - alpha0);
+            if(tc - t > 1.0e-3 * h) {
+                hcut = FMIN(hcut, tc - t);
+            }
+        }
+    }
+
+    return hcut;
+}
+
+// Stores the continuous extension cont of the accepted step [t, t + h] from y to ynew,
+// and drops the steps no lag can reach. Returns the residual of cont: above 1 the step
+// is taken back and has to be repeated shorter. With state-dependent delays, a lag
+// argument crossing a jump inside the step makes a jump one level up.
+double ddeRecord(ddeHistory *history, void (*derivative)(const double *t, const double y[], double ydot[]), const errorNorm *norm, double t, const double y[], const double ynew[], double h, const double cont[]){
+
+    int contSize = history -> contSize;
+    double t1 = t + h;
+
+    // Block 1 Calculations: drop the segments no lag from t on can reach, which holds
+    // for a repeated step too
+    while(history -> count > 1 && history -> tStart[history -> head] + history -> step[history -> head] < t - history -> maxDelay) {
+        history -> head = (history -> head + 1) % history -> capacity;
+        history -> count -= 1;
+    }
+
+    // Block 2 Calculations: more steps within one maximum delay than slots, unroll and double
+    if(history -> count == history -> capacity) {
+        int capacity = 2 * history -> capacity;
+        double *tStart = (double *) malloc(sizeof(double) * capacity);
+        double *step = (double *) malloc(sizeof(double) * capacity);
+        double *segments = (double *) malloc(sizeof(double) * contSize * capacity);
+        for (int index = 0; index < history -> count; ++index) {
+            int slot = segmentSlot(history, index);
+            tStart[index] = history -> tStart[slot];
+            step[index] = history -> step[slot];
+            memcpy(&segments[contSize * index], &history -> cont[contSize * slot], sizeof(double) * contSize);
+        }
+        free(history -> tStart); free(history -> step); free(history -> cont);
+        history -> tStart = tStart; history -> step = step; history -> cont = segments;
+        history -> capacity = capacity; history -> head = 0;
+    }
+
+    // Block 3 Calculations: append the new segment
+    int slot = segmentSlot(history, history -> count);
+    history -> tStart[slot] = t;
+    history -> step[slot] = h;
+    memcpy(&history -> cont[contSize * slot], cont, sizeof(double) * contSize);
+    history -> count += 1;
+
+    // the lags read cont, whose error the embedded estimate of the step does not see: its
+    // residual measures it, as in Shampine's ddesd
+    double residual = interpolantResidual(derivative, history -> methodId, cont, t, h, norm, history -> NSYS);
+    if(residual > 1.0) {
+        history -> count -= 1;
+        return residual;
+    }
+
+    if(history -> delays != NULL) {
+        return residual;
+    }
+
+    // Block 4 Calculations: state-dependent jumps, the crossing located linearly in the step
+    int delayCount = history -> delayCount, count = history -> breakpointCount;
+    double tau0[delayCount], tau1[delayCount];
+    delaysAt(history, &t, y, tau0);
+    delaysAt(history, &t1, ynew, tau1);
+
+    for (int k = 0; k < delayCount; ++k) {
+        double alpha0 = t - tau0[k], alpha1 = t1 - tau1[k];
+        for (int index = 0; index < count; ++index) {
+            ddeBreakpoint source = history -> breakpoints[index];
+            double eps = breakpointTolerance(source.t);
+            if(source.level >= history -> maxLevel || alpha0 >= source.t - eps || alpha1 < source.t - eps) {
+                continue;
+            }
+            double tc = (alpha1 > alpha0) ? t + h * FMIN((source.t - alpha0) / (alpha1 - alpha0), 1.0) : t1;
+            addBreakpoint(history, tc, source.level + 1);
+        }
+    }
+
+    // jumps no lag can reach any more
+    int stale = 0;
+    while(stale < history -> breakpointCount - 1 && history -> breakpoints[stale].t < t1 - history -> maxDelay) {
+        stale += 1;
+    }
+    if(stale > 0) {
+        memmove(history -> breakpoints, &history -> breakpoints[stale], sizeof(ddeBreakpoint) * (history -> breakpointCount - stale));
+        history -> breakpointCount -= stale;
+    }
+
+    return residual;
+}
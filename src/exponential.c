@@ -0,0 +1,662 @@
+/*
+* Exponential integrators for semi-linear problems y' = L y + N(t, y): the matrix
+* exponential and phi functions, exponential time differencing (ETD-RK4) with a user
+* supplied linear part, the exponential Rosenbrock method of order 4 and the exact
+* propagator of linear constant coefficient systems.
+*/
+
+#include "exponential.h"
+#include "implicit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_linalg.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+
+#define UROUND 2.2e-16
+
+// workspace of the ETD-RK4 steps, which share the fixed stepsize method signature
+static expWork *activeWork = NULL;
+
+// ----------------------------------------------------------------------------
+//
+//                            Matrix Functions
+//
+// ----------------------------------------------------------------------------
+
+// out = c6 * A6 + c4 * A4 + c2 * A2 + c0 * I
+static void combine(gsl_matrix *out, double c6, const gsl_matrix *A6, double c4, const gsl_matrix *A4, double c2, const gsl_matrix *A2, double c0){
+
+    for (size_t row = 0; row < out -> size1; ++row) {
+        for (size_t col = 0; col < out -> size2; ++col) {
+            gsl_matrix_set(out, row, col, c6 * gsl_matrix_get(A6, row, col) + c4 * gsl_matrix_get(A4, row, col)
+                                        + c2 * gsl_matrix_get(A2, row, col) + ((row == col) ? c0 : 0.0));
+        }
+    }
+}
+
+// Matrix exponential E = e^A by scaling and squaring with the [13/13] Pade approximant
+// (Higham 2005): A is scaled by 2^-s until its 1-norm is below theta13, the approximant
+// r(A) = (V - U)^-1 (V + U) is formed from A^2, A^4 and A^6 and squared s times.
+void expm(const gsl_matrix *A, gsl_matrix *E){
+
+    // -- Parameters ----------------------------------------------------------
+    static double
+        b0 = 64764752532480000.0, b1 = 32382376266240000.0, b2 = 7771770303897600.0,
+        b3 = 1187353796428800.0, b4 = 129060195264000.0, b5 = 10559470521600.0,
+        b6 = 670442572800.0, b7 = 33522128640.0, b8 = 1323241920.0,
+        b9 = 40840800.0, b10 = 960960.0, b11 = 16380.0, b12 = 182.0, b13 = 1.0,
+        theta13 = 5.371920351148152;
+
+    size_t n = A -> size1;
+    double norm = 0.0, colSum;
+    int squarings = 0, signum;
+
+    for (size_t col = 0; col < n; ++col) {
+        colSum = 0.0;
+        for (size_t row = 0; row < n; ++row) {
+            colSum += fabs(gsl_matrix_get(A, row, col));
+        }
+        norm = FMAX(norm, colSum);
+    }
+
+    if(norm > theta13) {
+        squarings = (int) ceil(log2(norm / theta13));
+    }
+
+    gsl_matrix *X = gsl_matrix_alloc(n, n), *A2 = gsl_matrix_alloc(n, n), *A4 = gsl_matrix_alloc(n, n), *A6 = gsl_matrix_alloc(n, n);
+    gsl_matrix *U = gsl_matrix_alloc(n, n), *V = gsl_matrix_alloc(n, n), *temp = gsl_matrix_alloc(n, n);
+    gsl_permutation *perm = gsl_permutation_alloc(n);
+    gsl_vector *column = gsl_vector_alloc(n);
+
+    gsl_matrix_memcpy(X, A);
+    gsl_matrix_scale(X, ldexp(1.0, -squarings));
+
+    // Block 1 Calculations: even powers
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, X, X, 0.0, A2);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A2, A2, 0.0, A4);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A4, A2, 0.0, A6);
+
+    // Block 2 Calculations: odd part U = X (A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I)
+    combine(temp, b13, A6, b11, A4, b9, A2, 0.0);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A6, temp, 0.0, V);
+    combine(temp, b7, A6, b5, A4, b3, A2, b1);
+    gsl_matrix_add(V, temp);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, X, V, 0.0, U);
+
+    // Block 3 Calculations: even part V = A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+    combine(temp, b12, A6, b10, A4, b8, A2, 0.0);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A6, temp, 0.0, V);
+    combine(temp, b6, A6, b4, A4, b2, A2, b0);
+    gsl_matrix_add(V, temp);
+
+    // Block 4 Calculations: (V - U) E = V + U, column by column
+    gsl_matrix_memcpy(temp, V);
+    gsl_matrix_sub(temp, U);
+    gsl_matrix_add(V, U);
+    gsl_linalg_LU_decomp(temp, perm, &signum);
+
+    for (size_t col = 0; col < n; ++col) {
+        for (size_t row = 0; row < n; ++row) {
+            gsl_vector_set(column, row, gsl_matrix_get(V, row, col));
+        }
+        gsl_linalg_LU_svx(temp, perm, column);
+        for (size_t row = 0; row < n; ++row) {
+            gsl_matrix_set(E, row, col, gsl_vector_get(column, row));
+        }
+    }
+
+    // Block 5 Calculations: undo the scaling
+    for (int square = 0; square < squarings; ++square) {
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, E, E, 0.0, temp);
+        gsl_matrix_memcpy(E, temp);
+    }
+
+    gsl_matrix_free(X); gsl_matrix_free(A2); gsl_matrix_free(A4); gsl_matrix_free(A6);
+    gsl_matrix_free(U); gsl_matrix_free(V); gsl_matrix_free(temp);
+    gsl_permutation_free(perm);
+    gsl_vector_free(column);
+}
+
+// phi[0] = e^A and phi[k] = phi_k(A), k = 1 .. p, with phi_k(z) = (phi_{k-1}(z) - 1/(k-1)!)/z,
+// read off the first block row of the exponential of the augmented matrix
+//     [A I 0 .. 0; 0 0 I .. 0; ..; 0 0 0 .. I; 0 0 0 .. 0]
+// of p + 1 blocks, which stays accurate where the recurrence cancels.
+void phiMatrices(const gsl_matrix *A, int p, gsl_matrix *phi[]){
+
+    size_t n = A -> size1, N = (p + 1) * n;
+    gsl_matrix *W = gsl_matrix_calloc(N, N), *EW = gsl_matrix_alloc(N, N);
+
+    for (size_t row = 0; row < n; ++row) {
+        for (size_t col = 0; col < n; ++col) {
+            gsl_matrix_set(W, row, col, gsl_matrix_get(A, row, col));
+        }
+    }
+    for (size_t index = n; index < N; ++index) {
+        gsl_matrix_set(W, index - n, index, 1.0);
+    }
+
+    expm(W, EW);
+
+    for (int k = 0; k <= p; ++k) {
+        for (size_t row = 0; row < n; ++row) {
+            for (size_t col = 0; col < n; ++col) {
+                gsl_matrix_set(phi[k], row, col, gsl_matrix_get(EW, row, k * n + col));
+            }
+        }
+    }
+
+    gsl_matrix_free(W);
+    gsl_matrix_free(EW);
+}
+
+// phi[0] = e^z and phi[k] = phi_k(z), k = 1 .. p: by their series sum(z^j/(j + k)!) for
+// |z| < 1, where the recurrence would cancel, and by the recurrence otherwise
+void phiScalars(double z, int p, double phi[]){
+
+    double factorial = 1.0, term, sum;
+
+    phi[0] = exp(z);
+
+    if(fabs(z) < 1.0) {
+        for (int k = 1; k <= p; ++k) {
+            factorial *= k;
+            term = 1.0 / factorial;
+            sum = term;
+            for (int j = 1; j < 25; ++j) {
+                term *= z / (j + k);
+                sum += term;
+            }
+            phi[k] = sum;
+        }
+    } else {
+        for (int k = 1; k <= p; ++k) {
+            phi[k] = (phi[k - 1] - 1.0 / factorial) / z;
+            factorial *= k;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Workspace
+//
+// ----------------------------------------------------------------------------
+
+// L is the linear part of ETD-RK4 or the matrix A of a linear system, NSYS entries when
+// diagonal and NSYS x NSYS row-major otherwise; NULL for the Rosenbrock method, which
+// linearises every step
+expWork * expAlloc(int NSYS, const double *L, bool diagonal, bool linear){
+
+    expWork *work = (expWork *) malloc(sizeof(expWork));
+    int size = diagonal ? NSYS : NSYS * NSYS;
+
+    work -> NSYS = NSYS;
+    work -> diagonal = diagonal;
+    work -> linear = linear;
+    work -> uses = 0;
+    work -> L = NULL;
+    work -> jac = NULL;
+    work -> jacValid = false;
+
+    for (int entry = 0; entry < EXP_CACHESIZE; ++entry) {
+        work -> cache[entry] = (phiCache) { .h = 0.0, .lastUse = 0, .phi = NULL };
+    }
+
+    if(L != NULL) {
+        work -> L = (double *) malloc(sizeof(double) * size);
+        memcpy(work -> L, L, sizeof(double) * size);
+        for (int entry = 0; entry < EXP_CACHESIZE; ++entry) {
+            work -> cache[entry].phi = (double *) malloc(sizeof(double) * (linear ? 2 : 6) * size);
+        }
+        activeWork = work;
+    } else {
+        work -> jac = gsl_matrix_alloc(NSYS + 1, NSYS + 1);
+    }
+
+    return work;
+}
+
+void expFree(expWork *work){
+
+    if(work == NULL) {
+        return;
+    }
+
+    for (int entry = 0; entry < EXP_CACHESIZE; ++entry) {
+        free(work -> cache[entry].phi);
+    }
+    free(work -> L);
+    if(work -> jac != NULL) {
+        gsl_matrix_free(work -> jac);
+    }
+    if(activeWork == work) {
+        activeWork = NULL;
+    }
+    free(work);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            ETD-RK4
+//
+// ----------------------------------------------------------------------------
+
+// phi functions of the stepsize h, from the cache or computed into its least recently
+// used entry. Stepsizes within 1e-12 of a cached one share it: the shortened last steps
+// of the output intervals differ from the step only by roundoff.
+static const double * phiLookup(expWork *work, double h){
+
+    int NSYS = work -> NSYS, size = work -> diagonal ? NSYS : NSYS * NSYS;
+    phiCache *entry = &work -> cache[0];
+
+    work -> uses += 1;
+
+    for (int index = 0; index < EXP_CACHESIZE; ++index) {
+        phiCache *cached = &work -> cache[index];
+        if(cached -> h != 0.0 && fabs(cached -> h - h) <= 1.0e-12 * fabs(h)) {
+            cached -> lastUse = work -> uses;
+            return cached -> phi;
+        }
+        if(cached -> lastUse < entry -> lastUse) {
+            entry = cached;
+        }
+    }
+
+    // the linear system propagator needs e^(hL) and phi1(hL) only
+    int p = work -> linear ? 1 : 3, first = work -> linear ? 0 : 2;
+
+    if(work -> diagonal) {
+        double half[2], full[4];
+        for (int var = 0; var < NSYS; ++var) {
+            if(!work -> linear) {
+                phiScalars(0.5 * h * work -> L[var], 1, half);
+                for (int k = 0; k < 2; ++k) {
+                    entry -> phi[k * size + var] = half[k];
+                }
+            }
+            phiScalars(h * work -> L[var], p, full);
+            for (int k = 0; k <= p; ++k) {
+                entry -> phi[(k + first) * size + var] = full[k];
+            }
+        }
+    } else {
+        gsl_matrix *A = gsl_matrix_alloc(NSYS, NSYS), *phi[4];
+        for (int k = 0; k < 4; ++k) {
+            phi[k] = gsl_matrix_alloc(NSYS, NSYS);
+        }
+
+        for (int half = work -> linear ? 0 : 1; half >= 0; --half) {
+            double scale = half ? 0.5 * h : h;
+            int order = half ? 1 : p, block = half ? 0 : first;
+
+            for (int index = 0; index < size; ++index) {
+                gsl_matrix_set(A, index / NSYS, index % NSYS, scale * work -> L[index]);
+            }
+            phiMatrices(A, order, phi);
+
+            for (int k = 0; k <= order; ++k) {
+                for (int index = 0; index < size; ++index) {
+                    entry -> phi[(block + k) * size + index] = gsl_matrix_get(phi[k], index / NSYS, index % NSYS);
+                }
+            }
+        }
+
+        gsl_matrix_free(A);
+        for (int k = 0; k < 4; ++k) {
+            gsl_matrix_free(phi[k]);
+        }
+    }
+
+    entry -> h = h;
+    entry -> lastUse = work -> uses;
+
+    return entry -> phi;
+}
+
+// out = M x for one of the cached functions M
+static inline void applyPhi(const expWork *work, const double *M, const double x[], double out[]){
+
+    int NSYS = work -> NSYS;
+
+    for (int row = 0; row < NSYS; ++row) {
+        if(work -> diagonal) {
+            out[row] = M[row] * x[row];
+        } else {
+            out[row] = 0.0;
+            for (int col = 0; col < NSYS; ++col) {
+                out[row] += M[row * NSYS + col] * x[col];
+            }
+        }
+    }
+}
+
+// nonlinear part N(t, y) = f(t, y) - L y
+static inline void nonlinear(void (*derivative)(const double *t, const double y[], double ydot[]), const expWork *work, const double *t, const double y[], double N[]){
+
+    double Ly[work -> NSYS];
+
+    derivative(t, y, N);
+    applyPhi(work, work -> L, y, Ly);
+
+    for (int var = 0; var < work -> NSYS; ++var) {
+        N[var] -= Ly[var];
+    }
+}
+
+// Method ID = 20
+// Exponential time differencing RK4 (Cox & Matthews 2002) for y' = L y + N(t, y) with the
+// linear part L from the input file, solved exactly by its exponential: stiff linear
+// modes do not limit the step. The phi functions of each stepsize are cached.
+void ETDRK4(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double step, int NSYS){
+
+    expWork *work = activeWork;
+    int size = work -> diagonal ? NSYS : NSYS * NSYS;
+    const double *phi = phiLookup(work, step);
+    const double *Ehalf = phi, *P1half = &phi[size], *E = &phi[2 * size], *P1 = &phi[3 * size], *P2 = &phi[4 * size], *P3 = &phi[5 * size];
+    double Nn[NSYS], Na[NSYS], Nb[NSYS], Nc[NSYS], a[NSYS], b[NSYS], c[NSYS], u[NSYS], v[NSYS], w[NSYS];
+    double t_half = *t + 0.5 * step, t_new = *t + step;
+
+    // Block 1 Calculations
+    nonlinear(derivative, work, t, y, Nn);
+    applyPhi(work, Ehalf, y, u);
+    applyPhi(work, P1half, Nn, v);
+    for (int var = 0; var < NSYS; ++var) {
+        a[var] = u[var] + 0.5 * step * v[var];
+    }
+
+    // Block 2 Calculations
+    nonlinear(derivative, work, &t_half, a, Na);
+    applyPhi(work, P1half, Na, v);
+    for (int var = 0; var < NSYS; ++var) {
+        b[var] = u[var] + 0.5 * step * v[var];
+    }
+
+    // Block 3 Calculations
+    nonlinear(derivative, work, &t_half, b, Nb);
+    for (int var = 0; var < NSYS; ++var) {
+        w[var] = 2.0 * Nb[var] - Nn[var];
+    }
+    applyPhi(work, Ehalf, a, u);
+    applyPhi(work, P1half, w, v);
+    for (int var = 0; var < NSYS; ++var) {
+        c[var] = u[var] + 0.5 * step * v[var];
+    }
+
+    // Block 4 Calculations
+    nonlinear(derivative, work, &t_new, c, Nc);
+
+    // Block 5 Calculations: y = E y + h (P1 Nn + P2 (-3 Nn + 2 Na + 2 Nb - Nc) + 4 P3 (Nn - Na - Nb + Nc))
+    applyPhi(work, E, y, u);
+    for (int var = 0; var < NSYS; ++var) {
+        y[var] = u[var];
+    }
+    applyPhi(work, P1, Nn, u);
+    for (int var = 0; var < NSYS; ++var) {
+        y[var] += step * u[var];
+        w[var] = -3.0 * Nn[var] + 2.0 * Na[var] + 2.0 * Nb[var] - Nc[var];
+    }
+    applyPhi(work, P2, w, u);
+    for (int var = 0; var < NSYS; ++var) {
+        y[var] += step * u[var];
+        w[var] = 4.0 * (Nn[var] - Na[var] - Nb[var] + Nc[var]);
+    }
+    applyPhi(work, P3, w, u);
+    for (int var = 0; var < NSYS; ++var) {
+        y[var] += step * u[var];
+    }
+
+    *t += step;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Linear Systems
+//
+// ----------------------------------------------------------------------------
+
+// Method ID = 22
+// Linear systems with constant coefficients y' = A y + b: over a stretch d on which b is
+// constant the solution is y(t + d) = e^(Ad) y + d phi1(Ad) b exactly, so the step is the
+// output interval and costs two matrix-vector products once e^(Ad) and phi1(Ad) are
+// cached. A is the linearOperator of the input file. The pieces of a piecewise constant
+// linearForcing split the step at their start times; without linearForcing b = f(t, 0)
+// is held over the step.
+void LinearExpm(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double step, odeOptions *options){
+
+    expWork *work = options -> exponential;
+    int NSYS = options -> NSYS, size = work -> diagonal ? NSYS : NSYS * NSYS;
+    int pieces = options -> forcingPieces, piece = 0;
+    double t_end = *t + step, zero[NSYS], b[NSYS], u[NSYS], v[NSYS];
+
+    // first piece starting after t, switches within roundoff of t or t_end are ignored
+    double slack = 1.0e-12 * fabs(step);
+    while(piece < pieces && options -> linearForcing[piece * (NSYS + 1)] <= *t + slack) {
+        ++piece;
+    }
+
+    do {
+        double t_next = t_end;
+        if(piece < pieces && options -> linearForcing[piece * (NSYS + 1)] < t_end - slack) {
+            t_next = options -> linearForcing[piece * (NSYS + 1)];
+        }
+
+        // forcing of the stretch, zero before the first piece
+        for (int var = 0; var < NSYS; ++var) {
+            zero[var] = 0.0;
+            b[var] = (piece > 0) ? options -> linearForcing[(piece - 1) * (NSYS + 1) + 1 + var] : 0.0;
+        }
+        if(options -> linearForcing == NULL) {
+            derivative(t, zero, b);
+        }
+
+        double d = t_next - *t;
+        const double *phi = phiLookup(work, d);
+        applyPhi(work, phi, y, u);
+        applyPhi(work, &phi[size], b, v);
+        for (int var = 0; var < NSYS; ++var) {
+            y[var] = u[var] + d * v[var];
+        }
+
+        *t = t_next;
+        ++piece;
+    } while(*t < t_end);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Exponential Rosenbrock
+//
+// ----------------------------------------------------------------------------
+
+// D(U) = F(U) - F(Y) - J (U - Y), the nonlinear remainder of the linearisation at Y
+static void linearRemainder(void (*derivative)(const double *t, const double y[], double ydot[]), const expWork *work, const double Y[], const double F[], const double U[], double D[], int NSYS){
+
+    double fU[NSYS], t_U = U[NSYS];
+
+    derivative(&t_U, U, fU);
+
+    for (int row = 0; row < NSYS; ++row) {
+        D[row] = fU[row] - F[row];
+        for (int col = 0; col <= NSYS; ++col) {
+            D[row] -= gsl_matrix_get(work -> jac, row, col) * (U[col] - Y[col]);
+        }
+    }
+    D[NSYS] = 0.0;
+}
+
+// out = M x for an (NSYS + 1) x (NSYS + 1) matrix
+static inline void matrixApply(const gsl_matrix *M, const double x[], double out[], int m){
+
+    for (int row = 0; row < m; ++row) {
+        out[row] = 0.0;
+        for (int col = 0; col < m; ++col) {
+            out[row] += gsl_matrix_get(M, row, col) * x[col];
+        }
+    }
+}
+
+// Method ID = 21
+// Exponential Rosenbrock method exprb43 (Hochbruck, Ostermann & Schweitzer 2009) on the
+// autonomous system Y = (y, t), Y' = F(Y) = (f(t, y), 1), linearised at the step start by
+// the finite difference Jacobian J (kept by the trials of a step), D as in linearRemainder():
+//     U2 = Y + h/2 phi1(hJ/2) F
+//     U3 = Y + h phi1(hJ) (F + D(U2))
+//     Ynew = Y + h phi1(hJ) F + h (16 phi3 - 48 phi4)(hJ) D(U2) + h (12 phi4 - 2 phi3)(hJ) D(U3)
+// of order 4, with the embedded solution of order 3 without the phi4 terms (Caliari &
+// Ostermann 2009). The stages sample the right hand side at t + h/2 and t + h, adaptive
+// steps also check the remainder of the linearisation at t + h/4 and t + 3h/4 and leave
+// f(t + h, ytemp) in K[1]. K[0] holds f(t, y) from the caller.
+double ExpRosenbrock43(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, odeOptions *options){
+
+    expWork *work = options -> exponential;
+    int NSYS = options -> NSYS, m = NSYS + 1;
+    double *dydt = options -> stages;
+    double Y[m], F[m], U[m], D2[m], D3[m], w[m], v[m], err[m];
+
+    // Jacobian of the augmented system at the step start, df/dt in the last column
+    if(work -> jacValid == false || work -> jacTime != *t) {
+        gsl_matrix *J = gsl_matrix_alloc(NSYS, NSYS);
+        double t_shift, delta = sqrt(UROUND * FMAX(1.0e-5, fabs(*t))), fshift[NSYS];
+
+        int calls = jacobianFD(derivative, t, y, dydt, J, NSYS);
+        t_shift = *t + delta;
+        derivative(&t_shift, y, fshift);
+
+        gsl_matrix_set_zero(work -> jac);
+        for (int row = 0; row < NSYS; ++row) {
+            for (int col = 0; col < NSYS; ++col) {
+                gsl_matrix_set(work -> jac, row, col, gsl_matrix_get(J, row, col));
+            }
+            gsl_matrix_set(work -> jac, row, NSYS, (fshift[row] - dydt[row]) / delta);
+        }
+        gsl_matrix_free(J);
+
+        options -> stats.rhsCalls += calls + 1;
+        options -> stats.jacobians += 1;
+        work -> jacTime = *t;
+        work -> jacValid = true;
+    }
+
+    // phi functions of h J / 2 and h J
+    gsl_matrix *A = gsl_matrix_alloc(m, m), *half[2], *phi[5];
+    for (int k = 0; k < 5; ++k) {
+        phi[k] = gsl_matrix_alloc(m, m);
+        if(k < 2) {
+            half[k] = gsl_matrix_alloc(m, m);
+        }
+    }
+    gsl_matrix_memcpy(A, work -> jac);
+    gsl_matrix_scale(A, 0.5 * step);
+    phiMatrices(A, 1, half);
+    gsl_matrix_scale(A, 2.0);
+    phiMatrices(A, 4, phi);
+
+    for (int var = 0; var < NSYS; ++var) {
+        Y[var] = y[var];
+        F[var] = dydt[var];
+    }
+    Y[NSYS] = *t;
+    F[NSYS] = 1.0;
+
+    // Block 1 Calculations: U2 = Y + h/2 phi1(hJ/2) F
+    matrixApply(half[1], F, v, m);
+    for (int var = 0; var < m; ++var) {
+        U[var] = Y[var] + 0.5 * step * v[var];
+    }
+    linearRemainder(derivative, work, Y, F, U, D2, NSYS);
+
+    // Block 2 Calculations: U3 = Y + h phi1(hJ) (F + D2)
+    for (int var = 0; var < m; ++var) {
+        w[var] = F[var] + D2[var];
+    }
+    matrixApply(phi[1], w, v, m);
+    for (int var = 0; var < m; ++var) {
+        U[var] = Y[var] + step * v[var];
+    }
+    linearRemainder(derivative, work, Y, F, U, D3, NSYS);
+
+    // Block 3 Calculations: order 4 solution and the phi4 terms as its error estimate
+    matrixApply(phi[1], F, v, m);
+    for (int var = 0; var < m; ++var) {
+        U[var] = Y[var] + step * v[var];
+        w[var] = 16.0 * D2[var] - 2.0 * D3[var];
+    }
+    matrixApply(phi[3], w, v, m);
+    for (int var = 0; var < m; ++var) {
+        U[var] += step * v[var];
+        w[var] = -48.0 * D2[var] + 12.0 * D3[var];
+    }
+    matrixApply(phi[4], w, err, m);
+
+    gsl_matrix_free(A);
+    for (int k = 0; k < 5; ++k) {
+        gsl_matrix_free(phi[k]);
+        if(k < 2) {
+            gsl_matrix_free(half[k]);
+        }
+    }
+
+    // errors
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int var = 0; var < NSYS; ++var) {
+        err[var] *= step;
+        ytemp[var] = U[var] + err[var];
+
+        if(norm != NULL) {
+            ratio = err[var] / (norm -> absWeight[var] + norm -> relWeight[var] * FMAX(fabs(y[var]), fabs(ytemp[var])));
+            sumSquares += ratio * ratio;
+            maxRatio = FMAX(maxRatio, fabs(ratio));
+        }
+    }
+
+    if(norm == NULL) {
+        return 0.0;
+    }
+
+    double error = (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+
+    // Block 4 Calculations: the method takes the remainder D of the linearisation along
+    // the step as the quadratic q through D(Y) = 0, D2 and D3, and forcing between the
+    // stages is lost to the error estimate. D is checked at t + h/4 and t + 3h/4 on the
+    // cubic Hermite interpolant of the step, where its zero derivative at Y makes it
+    // insensitive to the interpolation error. A smooth deviation D - q is cubic with zeros
+    // at the stages and integrates to nearly nothing over the step, so h |D - q| / 4
+    // counts as the local error
+    double cont[4 * NSYS], *dydt_new = &options -> stages[options -> fsalSlot * NSYS];
+    double t_new = *t + step, defect = 0.0, q;
+
+    derivative(&t_new, ytemp, dydt_new);
+    Hermite_contd(y, ytemp, dydt, dydt_new, step, cont, NSYS);
+
+    for (int check = 1; check <= 3; check += 2) {
+
+        double theta = 0.25 * check;
+
+        polynomial_dense(theta, cont, 3, U, NSYS);
+        U[NSYS] = *t + theta * step;
+        linearRemainder(derivative, work, Y, F, U, w, NSYS);
+
+        sumSquares = 0.0; maxRatio = 0.0;
+        for (int var = 0; var < NSYS; ++var) {
+            q = theta * (4.0 * D2[var] - D3[var]) + theta * theta * (2.0 * D3[var] - 4.0 * D2[var]);
+            ratio = step * (w[var] - q) / (4.0 * (norm -> absWeight[var] + norm -> relWeight[var] * FMAX(fabs(y[var]), fabs(U[var]))));
+            sumSquares += ratio * ratio;
+            maxRatio = FMAX(maxRatio, fabs(ratio));
+        }
+        ratio = (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+        defect = FMAX(defect, ratio);
+    }
+
+    return FMAX(error, defect);
+}
@@ -0,0 +1,1613 @@
+/*
+* Implicit algorithms: Jacobians, iteration matrices and the implicit steppers
+* that carry them from step to step.
+*/
+
+#include "implicit.h"
+#include "mol.h"
+#include "sparsity.h"
+#include "taylor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_complex.h>
+#include <gsl/gsl_complex_math.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_linalg.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+#define FMIN(x, y) ( x < y ? x : y )
+
+#define UROUND 2.2e-16
+
+// weighted norm of v[i]/scal[i] over n entries, RMS or max as selected by the error norm
+static inline double weightedNorm(const double v[], const double scal[], int n, int NSYS, int type){
+
+    double sumSquares = 0.0, maxRatio = 0.0, ratio;
+
+    for (int index = 0; index < n; ++index) {
+        ratio = v[index] / scal[index % NSYS];
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return (type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / n);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Jacobian
+//
+// ----------------------------------------------------------------------------
+
+// Forward difference Jacobian on the columns of a sparsity pattern, into the dense
+// matrix or the band (the other one NULL): one derivative evaluation perturbs all
+// columns of a colour, whose rows do not overlap, and each changed output belongs to
+// the one column of the colour holding that row. Entries outside the pattern are zero,
+// those outside the band dropped. Returns the derivative evaluations used.
+static int jacobianColoredFD(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], const sparsityPattern *pattern, gsl_matrix *dense, bandMatrix *band){
+
+    int NSYS = pattern -> NSYS;
+    double yperturbed[NSYS], fperturbed[NSYS], delta[NSYS];
+
+    if(dense != NULL) {
+        gsl_matrix_set_zero(dense);
+    } else {
+        bandZero(band);
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        yperturbed[var] = y[var];
+        delta[var] = sqrt(UROUND * FMAX(1.0e-5, fabs(y[var])));
+    }
+
+    for (int c = 0; c < pattern -> colors; ++c) {
+
+        for (int index = pattern -> colorStart[c]; index < pattern -> colorStart[c + 1]; ++index) {
+            int col = pattern -> columns[index];
+            yperturbed[col] = y[col] + delta[col];
+        }
+
+        derivative(t, yperturbed, fperturbed);
+
+        for (int index = pattern -> colorStart[c]; index < pattern -> colorStart[c + 1]; ++index) {
+            int col = pattern -> columns[index];
+            for (int k = pattern -> colStart[col]; k < pattern -> colStart[col + 1]; ++k) {
+                int row = pattern -> rows[k];
+                double value = (fperturbed[row] - dydt[row]) / delta[col];
+                if(dense != NULL) {
+                    gsl_matrix_set(dense, row, col, value);
+                } else {
+                    bandAdd(band, row, col, value);
+                }
+            }
+            yperturbed[col] = y[col];
+        }
+    }
+
+    return pattern -> colors;
+}
+
+// Exact Jacobian of the taylorModel tape by one forward mode sweep, into the dense
+// matrix or the band (the other one NULL). The columns are compressed into the tangents
+// as the finite differences group them: by the colours of a sparsity pattern, by the
+// lower + upper + 1 groups of a band, else one tangent per column. The sweep counts as
+// one derivative evaluation.
+static int jacobianTape(const double *t, const double y[], const sparsityPattern *pattern, gsl_matrix *dense, bandMatrix *band, int NSYS){
+
+    int width = NSYS, group[NSYS];
+    double f[NSYS];
+
+    for (int col = 0; col < NSYS; ++col) {
+        group[col] = col;
+    }
+    if(pattern != NULL) {
+        width = pattern -> colors;
+        for (int c = 0; c < pattern -> colors; ++c) {
+            for (int index = pattern -> colorStart[c]; index < pattern -> colorStart[c + 1]; ++index) {
+                group[pattern -> columns[index]] = c;
+            }
+        }
+    } else if(band != NULL) {
+        width = FMIN(band -> lower + band -> upper + 1, NSYS);
+        for (int col = 0; col < NSYS; ++col) {
+            group[col] = col % width;
+        }
+    }
+
+    double *seed = (double *) calloc((size_t) NSYS * width, sizeof(double));
+    double *tangent = (double *) malloc(sizeof(double) * NSYS * width);
+
+    for (int col = 0; col < NSYS; ++col) {
+        seed[(long) col * width + group[col]] = 1.0;
+    }
+    taylorTangents(getTaylorModel(), *t, y, seed, width, f, tangent);
+
+    // row of a compressed tangent holds the entry of the one column of its group in the row
+    if(dense != NULL) {
+        gsl_matrix_set_zero(dense);
+    } else {
+        bandZero(band);
+    }
+    for (int col = 0; col < NSYS; ++col) {
+        int first = 0, last = NSYS - 1;
+        if(pattern == NULL && band != NULL) {
+            first = (col - band -> upper > 0) ? col - band -> upper : 0;
+            last = (col + band -> lower < NSYS - 1) ? col + band -> lower : NSYS - 1;
+        }
+        int count = (pattern != NULL) ? pattern -> colStart[col + 1] - pattern -> colStart[col] : last - first + 1;
+        for (int k = 0; k < count; ++k) {
+            int row = (pattern != NULL) ? pattern -> rows[pattern -> colStart[col] + k] : first + k;
+            double value = tangent[(long) row * width + group[col]];
+            if(dense != NULL) {
+                gsl_matrix_set(dense, row, col, value);
+            } else {
+                bandAdd(band, row, col, value);
+            }
+        }
+    }
+
+    free(seed);
+    free(tangent);
+
+    return 1;
+}
+
+// Forward difference Jacobian df/dy at (t, y) with dydt = f(t, y), one derivative
+// evaluation per column, increments sqrt(uround * max(1e-5, |y[j]|)) as in RADAU5.
+// The right hand side of a method-of-lines model gives its banded Jacobian instead, a
+// taylorModel its exact Jacobian, a model with a sparsity pattern one evaluation per
+// colour of its columns. Returns the derivative evaluations used.
+int jacobianFD(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], gsl_matrix *jac, int NSYS){
+
+    double yperturbed[NSYS], fperturbed[NSYS], delta;
+
+    if(derivative == molDerivative) {
+        return molJacobianDense(t, y, jac);
+    }
+    if(derivative == taylorDerivative) {
+        return jacobianTape(t, y, getSparsity(), jac, NULL, NSYS);
+    }
+    if(getSparsity() != NULL) {
+        return jacobianColoredFD(derivative, t, y, dydt, getSparsity(), jac, NULL);
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        yperturbed[var] = y[var];
+    }
+
+    for (int col = 0; col < NSYS; ++col) {
+        delta = sqrt(UROUND * FMAX(1.0e-5, fabs(y[col])));
+        yperturbed[col] = y[col] + delta;
+
+        derivative(t, yperturbed, fperturbed);
+
+        for (int row = 0; row < NSYS; ++row) {
+            gsl_matrix_set(jac, row, col, (fperturbed[row] - dydt[row]) / delta);
+        }
+        yperturbed[col] = y[col];
+    }
+
+    return NSYS;
+}
+
+// Forward difference Jacobian in the band of jac, by the column groups of Curtis, Powell
+// and Reid: columns lower + upper + 1 apart touch disjoint rows, so one derivative
+// evaluation perturbs a whole group and lower + upper + 1 evaluations fill the band.
+// Entries outside the band are dropped. Method-of-lines models assemble theirs from
+// the stencil, a taylorModel differentiates its tape, models with a sparsity pattern
+// take its colours when they are fewer.
+// Returns the derivative evaluations used.
+int jacobianBandFD(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], const double dydt[], bandMatrix *jac){
+
+    int NSYS = jac -> n, lower = jac -> lower, upper = jac -> upper, groups = lower + upper + 1;
+    double yperturbed[NSYS], fperturbed[NSYS], delta[NSYS];
+
+    if(derivative == molDerivative) {
+        return molJacobian(t, y, jac);
+    }
+    if(derivative == taylorDerivative) {
+        return jacobianTape(t, y, (getSparsity() != NULL && getSparsity() -> colors < FMIN(groups, NSYS)) ? getSparsity() : NULL, NULL, jac, NSYS);
+    }
+    if(getSparsity() != NULL && getSparsity() -> colors < FMIN(groups, NSYS)) {
+        return jacobianColoredFD(derivative, t, y, dydt, getSparsity(), NULL, jac);
+    }
+
+    groups = (groups < NSYS) ? groups : NSYS;
+
+    for (int var = 0; var < NSYS; ++var) {
+        yperturbed[var] = y[var];
+        delta[var] = sqrt(UROUND * FMAX(1.0e-5, fabs(y[var])));
+    }
+
+    for (int group = 0; group < groups; ++group) {
+
+        for (int col = group; col < NSYS; col += groups) {
+            yperturbed[col] = y[col] + delta[col];
+        }
+
+        derivative(t, yperturbed, fperturbed);
+
+        for (int col = group; col < NSYS; col += groups) {
+            int first = (col - upper > 0) ? col - upper : 0, last = (col + lower < NSYS - 1) ? col + lower : NSYS - 1;
+            for (int row = first; row <= last; ++row) {
+                BAND(jac, row, col) = (fperturbed[row] - dydt[row]) / delta[col];
+            }
+            yperturbed[col] = y[col];
+        }
+    }
+
+    return groups;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Radau IIA
+//
+// ----------------------------------------------------------------------------
+
+radauWork * radauAlloc(int NSYS, const double *mass, bool massDiagonal){
+
+    radauWork *work = (radauWork *) malloc(sizeof(radauWork));
+
+    work -> mass = mass;
+    work -> massDiagonal = massDiagonal;
+
+    work -> jac = gsl_matrix_alloc(NSYS, NSYS);
+    work -> E1 = gsl_matrix_alloc(NSYS, NSYS);
+    work -> E2 = gsl_matrix_complex_alloc(NSYS, NSYS);
+    work -> p1 = gsl_permutation_alloc(NSYS);
+    work -> p2 = gsl_permutation_alloc(NSYS);
+    work -> z = (double *) malloc(sizeof(double) * 3 * NSYS);
+    work -> f = (double *) malloc(sizeof(double) * 3 * NSYS);
+    work -> scal = (double *) malloc(sizeof(double) * NSYS);
+
+    work -> hLU = 0.0; work -> hOld = 0.0;
+    work -> theta = 0.0; work -> faccon = 1.0;
+    work -> hAcc = 0.0; work -> errAcc = 1.0e-2;
+    work -> first = true; work -> reject = false;
+    work -> jacValid = false; work -> jacFresh = false; work -> luValid = false;
+
+    return work;
+}
+
+void radauFree(radauWork *work){
+
+    if(work == NULL) {
+        return;
+    }
+
+    gsl_matrix_free(work -> jac);
+    gsl_matrix_free(work -> E1);
+    gsl_matrix_complex_free(work -> E2);
+    gsl_permutation_free(work -> p1);
+    gsl_permutation_free(work -> p2);
+    free(work -> z);
+    free(work -> f);
+    free(work -> scal);
+    free(work);
+}
+
+// Radau IIA nodes, error estimate and transformation to the eigenbasis (T, T^-1)
+static const double c1 = 0.15505102572168219018, c2 = 0.64494897427831780982;
+static const double dd1 = -10.048809399827415562, dd2 = 1.3821427331607488958, dd3 = -0.33333333333333333333;
+static const double t11 = 9.1232394870892942792e-02, t12 = -0.14125529502095420843, t13 = -3.0029194105147424492e-02;
+static const double t21 = 0.24171793270710701896, t22 = 0.20412935229379993199, t23 = 0.38294211275726193779;
+static const double t31 = 0.96604818261509293619;
+static const double ti11 = 4.3255798900631553510, ti12 = 0.33919925181580986954, ti13 = 0.54177053993587487119;
+static const double ti21 = -4.1787185915519047273, ti22 = -0.32768282076106238708, ti23 = 0.47662355450055045196;
+static const double ti31 = -0.50287263494578687595, ti32 = 2.5719269498556054292, ti33 = -0.59603920482822492497;
+
+// entry (row, col) of the mass matrix
+static inline double massEntry(const radauWork *work, int row, int col, int NSYS){
+
+    if(work -> mass == NULL) {
+        return (row == col) ? 1.0 : 0.0;
+    }
+    if(work -> massDiagonal) {
+        return (row == col) ? work -> mass[row] : 0.0;
+    }
+    return work -> mass[row * NSYS + col];
+}
+
+// out = M x
+static void massMultiply(const radauWork *work, const double x[], double out[], int NSYS){
+
+    for (int row = 0; row < NSYS; ++row) {
+        if(work -> mass == NULL || work -> massDiagonal) {
+            out[row] = massEntry(work, row, row, NSYS) * x[row];
+            continue;
+        }
+        out[row] = 0.0;
+        for (int col = 0; col < NSYS; ++col) {
+            out[row] += work -> mass[row * NSYS + col] * x[col];
+        }
+    }
+}
+
+// real eigenvalue gamma and complex pair alpha +- i beta of the inverse Radau matrix
+static void radauEigenvalues(double *gamma, double *alpha, double *beta){
+
+    double cbrt81 = cbrt(81.0), cbrt9 = cbrt(9.0);
+    double u1 = (6.0 + cbrt81 - cbrt9) / 30.0;
+    double alph = (12.0 - cbrt81 + cbrt9) / 60.0;
+    double bet = (cbrt81 + cbrt9) * sqrt(3.0) / 60.0;
+    double cno = alph * alph + bet * bet;
+
+    *gamma = 1.0 / u1;
+    *alpha = alph / cno;
+    *beta = bet / cno;
+}
+
+static void radauDecompose(radauWork *work, double h, int NSYS){
+
+    double gamma, alpha, beta;
+    int signum;
+
+    radauEigenvalues(&gamma, &alpha, &beta);
+
+    for (int row = 0; row < NSYS; ++row) {
+        for (int col = 0; col < NSYS; ++col) {
+            double jij = gsl_matrix_get(work -> jac, row, col), mij = massEntry(work, row, col, NSYS);
+            gsl_matrix_set(work -> E1, row, col, mij * gamma / h - jij);
+            gsl_matrix_complex_set(work -> E2, row, col, gsl_complex_rect(mij * alpha / h - jij, mij * beta / h));
+        }
+    }
+
+    gsl_linalg_LU_decomp(work -> E1, work -> p1, &signum);
+    gsl_linalg_complex_LU_decomp(work -> E2, work -> p2, &signum);
+
+    work -> hLU = h;
+    work -> luValid = true;
+}
+
+// solves the transformed Newton system in place: z1 with E1, z2 + i z3 with E2
+static void radauSolve(radauWork *work, double h, int NSYS){
+
+    double gamma, alpha, beta;
+    double *z1 = work -> z, *z2 = &work -> z[NSYS], *z3 = &work -> z[2 * NSYS];
+    double *f1 = work -> f, *f2 = &work -> f[NSYS], *f3 = &work -> f[2 * NSYS];
+    double z23[2 * NSYS], m1[NSYS], m2[NSYS], m3[NSYS];
+
+    radauEigenvalues(&gamma, &alpha, &beta);
+
+    massMultiply(work, f1, m1, NSYS);
+    massMultiply(work, f2, m2, NSYS);
+    massMultiply(work, f3, m3, NSYS);
+
+    for (int index = 0; index < NSYS; ++index) {
+        z1[index] -= m1[index] * gamma / h;
+        z23[2 * index] = z2[index] - m2[index] * alpha / h + m3[index] * beta / h;
+        z23[2 * index + 1] = z3[index] - m3[index] * alpha / h - m2[index] * beta / h;
+    }
+
+    gsl_vector_view real = gsl_vector_view_array(z1, NSYS);
+    gsl_vector_complex_view cplx = gsl_vector_complex_view_array(z23, NSYS);
+    gsl_linalg_LU_svx(work -> E1, work -> p1, &real.vector);
+    gsl_linalg_complex_LU_svx(work -> E2, work -> p2, &cplx.vector);
+
+    for (int index = 0; index < NSYS; ++index) {
+        z2[index] = z23[2 * index];
+        z3[index] = z23[2 * index + 1];
+    }
+}
+
+// Method ID = 16
+// 3-stage Radau IIA collocation method of order 5 (Hairer & Wanner, RADAU5). The 3N x 3N
+// Newton system is diagonalised by the eigenvectors T of the inverse Radau matrix, which
+// leaves one real N x N system with (gamma/h) M - J and one complex N x N system with
+// ((alpha + i beta)/h) M - J, both LU decomposed once per Jacobian or stepsize change.
+// M is the identity unless a mass matrix is given; the algebraic equations of an index-1
+// DAE then enter the same Newton iteration as the stages.
+// The Jacobian is reused while Newton contracts fast, and the stepsize and LU are kept when
+// the new stepsize would change by less than 20%.
+//
+// options -> stages[0] holds f(t, y). *h enters as the trial stepsize and leaves as the
+// accepted one; ytemp receives the new solution, options -> stages[fsalSlot] f(t + h, ytemp)
+// and options -> cont the collocation polynomial of the step. Returns the next stepsize.
+double RadauIIA5(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double *h, const errorNorm *norm, odeOptions *options){
+
+    // {'nit': Newton iterations per trial, 'thet': Jacobian kept below this contraction rate }
+    // {'quot1, quot2': stepsize and LU kept if the new stepsize is within this factor }
+    static int nit = 7;
+    static double safe = 0.9, facl = 5.0, facr = 0.125, thet = 0.001, quot1 = 1.0, quot2 = 1.2;
+
+    int NSYS = options -> NSYS, newt, type = (norm != NULL) ? norm -> type : ERRORNORM_RMS;
+    radauWork *work = options -> radau;
+    double *y0 = options -> stages, *cont = options -> cont, *scal = work -> scal;
+    double *z1 = work -> z, *z2 = &work -> z[NSYS], *z3 = &work -> z[2 * NSYS];
+    double *f1 = work -> f, *f2 = &work -> f[NSYS], *f3 = &work -> f[2 * NSYS];
+    double ystage[NSYS], fstage[NSYS], est[NSYS], tstage;
+    double fnewt = 0.0, dyno, dynold = 0.0, thq, thqold = 0.0, dyth, qnewt, err, fac, quot, hnew, rtol;
+    double c1m1 = c1 - 1.0, c2m1 = c2 - 1.0, c1mc2 = c1 - c2;
+    bool diverged, slow;
+
+    // the embedded estimate is only of order 3, so the tolerances are tightened as in
+    // RADAU5: rtol' = 0.1 rtol^(2/3), scaling each weight by rtol'/rtol
+    for (int var = 0; var < NSYS; ++var) {
+        rtol = FMAX(options -> relTol[var], 1.0e-14);
+        scal[var] = ((norm != NULL) ? norm -> absWeight[var] + norm -> relWeight[var] * fabs(y[var]) : 1.0)
+                  * 0.1 * pow(rtol, -1.0/3.0);
+        rtol = 0.1 * pow(rtol, 2.0/3.0);
+        fnewt = FMAX(fnewt, FMAX(10.0 * UROUND / rtol, FMIN(0.03, sqrt(rtol))));
+    }
+
+    while(true) {
+
+        // Jacobian at (t, y), unless the last one still serves
+        if(work -> jacValid == false) {
+            options -> stats.rhsCalls += jacobianFD(derivative, t, y, y0, work -> jac, NSYS);
+            options -> stats.jacobians += 1;
+            work -> jacValid = true;
+            work -> jacFresh = true;
+            work -> luValid = false;
+        }
+
+        if(work -> luValid == false || *h != work -> hLU) {
+            radauDecompose(work, *h, NSYS);
+            options -> stats.decompositions += 1;
+        }
+
+        // starting values from the collocation polynomial of the last step
+        if(work -> first) {
+            for (int index = 0; index < 3 * NSYS; ++index) {
+                work -> z[index] = 0.0;
+                work -> f[index] = 0.0;
+            }
+        } else {
+            double c3q = *h / work -> hOld, c1q = c1 * c3q, c2q = c2 * c3q, ak1, ak2, ak3;
+
+            for (int index = 0; index < NSYS; ++index) {
+                ak1 = cont[NSYS + index]; ak2 = cont[2 * NSYS + index]; ak3 = cont[3 * NSYS + index];
+                z1[index] = c1q * (ak1 + (c1q - c2m1) * (ak2 + (c1q - c1m1) * ak3));
+                z2[index] = c2q * (ak1 + (c2q - c2m1) * (ak2 + (c2q - c1m1) * ak3));
+                z3[index] = c3q * (ak1 + (c3q - c2m1) * (ak2 + (c3q - c1m1) * ak3));
+                f1[index] = ti11 * z1[index] + ti12 * z2[index] + ti13 * z3[index];
+                f2[index] = ti21 * z1[index] + ti22 * z2[index] + ti23 * z3[index];
+                f3[index] = ti31 * z1[index] + ti32 * z2[index] + ti33 * z3[index];
+            }
+        }
+
+        // simplified Newton iteration
+        work -> faccon = pow(FMAX(work -> faccon, UROUND), 0.8);
+        work -> theta = fabs(thet);
+        diverged = false; slow = false;
+
+        for (newt = 1; ; ++newt) {
+
+            if(newt >= nit) {
+                diverged = true;
+                break;
+            }
+
+            // stage derivatives
+            double *zs[3] = {z1, z2, z3}, cs[3] = {c1, c2, 1.0};
+            for (int s = 0; s < 3; ++s) {
+                tstage = *t + cs[s] * *h;
+                for (int index = 0; index < NSYS; ++index) {
+                    ystage[index] = y[index] + zs[s][index];
+                }
+                derivative(&tstage, ystage, fstage);
+                for (int index = 0; index < NSYS; ++index) {
+                    zs[s][index] = fstage[index];
+                }
+            }
+            options -> stats.rhsCalls += 3;
+
+            for (int index = 0; index < NSYS; ++index) {
+                double a1 = z1[index], a2 = z2[index], a3 = z3[index];
+                z1[index] = ti11 * a1 + ti12 * a2 + ti13 * a3;
+                z2[index] = ti21 * a1 + ti22 * a2 + ti23 * a3;
+                z3[index] = ti31 * a1 + ti32 * a2 + ti33 * a3;
+            }
+
+            radauSolve(work, *h, NSYS);
+
+            dyno = weightedNorm(work -> z, scal, 3 * NSYS, NSYS, ERRORNORM_RMS);
+
+            // contraction rate, and whether nit iterations can still converge
+            if(newt > 1 && newt < nit) {
+                thq = dyno / dynold;
+                work -> theta = (newt == 2) ? thq : sqrt(thq * thqold);
+                thqold = thq;
+
+                if(work -> theta < 0.99) {
+                    work -> faccon = work -> theta / (1.0 - work -> theta);
+                    dyth = work -> faccon * dyno * pow(work -> theta, nit - 1 - newt) / fnewt;
+                    if(dyth >= 1.0) {
+                        qnewt = FMAX(1.0e-4, FMIN(20.0, dyth));
+                        *h *= 0.8 * pow(qnewt, -1.0/(4.0 + nit - 1 - newt));
+                        slow = true;
+                        break;
+                    }
+                } else {
+                    diverged = true;
+                    break;
+                }
+            }
+
+            dynold = FMAX(dyno, UROUND);
+
+            for (int index = 0; index < NSYS; ++index) {
+                f1[index] += z1[index];
+                f2[index] += z2[index];
+                f3[index] += z3[index];
+                z1[index] = t11 * f1[index] + t12 * f2[index] + t13 * f3[index];
+                z2[index] = t21 * f1[index] + t22 * f2[index] + t23 * f3[index];
+                z3[index] = t31 * f1[index] + f2[index];
+            }
+
+            if(work -> faccon * dyno <= fnewt) {
+                break;
+            }
+        }
+
+        if(diverged || slow) {
+
+            // Newton failed or converges too slowly: retry with a smaller step,
+            // and a new Jacobian unless the current one was evaluated at (t, y)
+            *h *= diverged ? 0.5 : 1.0;
+            work -> reject = true;
+            options -> stats.rejected += 1;
+            work -> jacValid = work -> jacFresh;
+
+            if(*t + *h == *t) {
+                fprintf(stderr, "\nstepsize underflow in Radau IIA algorithm..now exiting to system\n");
+                exit(1);
+            }
+            continue;
+        }
+
+        // error estimate, filtered through E1 to stay bounded for stiff components
+        gsl_vector_view estimate = gsl_vector_view_array(est, NSYS);
+        double fe[NSYS];
+
+        for (int index = 0; index < NSYS; ++index) {
+            est[index] = (dd1 * z1[index] + dd2 * z2[index] + dd3 * z3[index]) / *h;
+        }
+        massMultiply(work, est, fe, NSYS);
+        for (int index = 0; index < NSYS; ++index) {
+            est[index] = fe[index] + y0[index];
+        }
+        gsl_linalg_LU_svx(work -> E1, work -> p1, &estimate.vector);
+        err = FMAX(weightedNorm(est, scal, NSYS, NSYS, type), 1.0e-10);
+
+        if(err >= 1.0 && (work -> first || work -> reject)) {
+            for (int index = 0; index < NSYS; ++index) {
+                ystage[index] = y[index] + est[index];
+            }
+            derivative(t, ystage, fstage);
+            options -> stats.rhsCalls += 1;
+
+            for (int index = 0; index < NSYS; ++index) {
+                est[index] = fstage[index] + fe[index];
+            }
+            gsl_linalg_LU_svx(work -> E1, work -> p1, &estimate.vector);
+            err = FMAX(weightedNorm(est, scal, NSYS, NSYS, type), 1.0e-10);
+        }
+
+        // stepsize proposal, damped by the Newton effort
+        fac = FMIN(safe, safe * (1 + 2 * nit) / (newt + 2 * nit));
+        quot = FMAX(facr, FMIN(facl, pow(err, 0.25) / fac));
+        hnew = *h / quot;
+
+        if(err < 1.0) {
+            break;
+        }
+
+        // rejected
+        options -> stats.rejected += 1;
+        *h = work -> first ? 0.1 * *h : hnew;
+        work -> reject = true;
+        work -> jacValid = work -> jacFresh;
+
+        if(*t + *h == *t) {
+            fprintf(stderr, "\nstepsize underflow in Radau IIA algorithm..now exiting to system\n");
+            exit(1);
+        }
+    }
+
+    options -> stats.accepted += 1;
+
+    // predictive (Gustafsson) stepsize control
+    if(work -> first == false) {
+        double facgus = (work -> hAcc / *h) * pow(err * err / work -> errAcc, 0.25) / safe;
+        facgus = FMAX(facr, FMIN(facl, facgus));
+        quot = FMAX(quot, facgus);
+        hnew = *h / quot;
+    }
+    work -> hAcc = *h;
+    work -> errAcc = FMAX(1.0e-2, err);
+
+    // new solution and its collocation polynomial, cont[0..NSYS) = ytemp
+    for (int index = 0; index < NSYS; ++index) {
+        double ak, acont3;
+
+        ytemp[index] = y[index] + z3[index];
+        cont[index] = ytemp[index];
+        cont[NSYS + index] = (z2[index] - z3[index]) / c2m1;
+        ak = (z1[index] - z2[index]) / c1mc2;
+        acont3 = (ak - z1[index] / c1) / c2;
+        cont[2 * NSYS + index] = (ak - cont[NSYS + index]) / c1m1;
+        cont[3 * NSYS + index] = cont[2 * NSYS + index] - acont3;
+    }
+
+    tstage = *t + *h;
+    derivative(&tstage, ytemp, &options -> stages[options -> fsalSlot * NSYS]);
+    options -> stats.rhsCalls += 1;
+
+    if(work -> reject) {
+        hnew = FMIN(hnew, *h);
+    }
+
+    work -> hOld = *h;
+    work -> first = false;
+    work -> reject = false;
+    work -> jacFresh = false;
+
+    // keep the stepsize (and LU) for small changes, the Jacobian while Newton contracts fast
+    if(work -> theta <= thet && hnew / *h >= quot1 && hnew / *h <= quot2) {
+        hnew = *h;
+    }
+    work -> jacValid = (work -> theta <= thet);
+
+    return hnew;
+}
+
+// Collocation polynomial of the last accepted step, theta in [0, 1] over the step.
+void Radau_dense(double theta, const double cont[], double yout[], int NSYS){
+
+    double s = theta - 1.0, c1m1 = c1 - 1.0, c2m1 = c2 - 1.0;
+
+    for (int index = 0; index < NSYS; ++index) {
+        yout[index] = cont[index] + s * (cont[NSYS + index] + (s - c2m1)
+                    * (cont[2 * NSYS + index] + (s - c1m1) * cont[3 * NSYS + index]));
+    }
+}
+
+// Derivative d/dtheta of the collocation polynomial of Radau_dense.
+void Radau_slope(double theta, const double cont[], double slope[], int NSYS){
+
+    double s = theta - 1.0, c1m1 = c1 - 1.0, c2m1 = c2 - 1.0, inner, outer;
+
+    for (int index = 0; index < NSYS; ++index) {
+        inner = cont[2 * NSYS + index] + (s - c1m1) * cont[3 * NSYS + index];
+        outer = cont[NSYS + index] + (s - c2m1) * inner;
+        slope[index] = outer + s * (inner + (s - c2m1) * cont[3 * NSYS + index]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Differential-Algebraic Equations
+//
+// ----------------------------------------------------------------------------
+
+// Consistent initial values of an index-1 DAE M y' = f(t, y) in semi-explicit form: the
+// zero rows of the mass matrix are the algebraic equations, its zero columns the
+// algebraic components. Newton's method on the algebraic equations moves the algebraic
+// components of yInitCond onto the constraints, the differential components stay as
+// given. A singular Jacobian of the algebraic equations means the DAE is not of index 1.
+void daeInitialize(void (*derivative)(const double *t, const double y[], double ydot[]), odeOptions *options){
+
+    int NSYS = options -> NSYS, rows[NSYS], cols[NSYS], nrows = 0, ncols = 0, signum;
+    const double *mass = options -> massMatrix;
+    double *y = options -> yInitCond, *t = &options -> domain[0];
+    double f[NSYS], fperturbed[NSYS], delta, step;
+
+    for (int var = 0; var < NSYS; ++var) {
+        bool zeroRow = true, zeroCol = true;
+        for (int k = 0; k < NSYS && options -> massDiagonal == false; ++k) {
+            zeroRow = zeroRow && (mass[var * NSYS + k] == 0.0);
+            zeroCol = zeroCol && (mass[k * NSYS + var] == 0.0);
+        }
+        if(options -> massDiagonal) {
+            zeroRow = zeroCol = (mass[var] == 0.0);
+        }
+        if(zeroRow) {
+            rows[nrows++] = var;
+        }
+        if(zeroCol) {
+            cols[ncols++] = var;
+        }
+    }
+
+    if(nrows != ncols) {
+        fprintf(stderr, "massMatrix has %d zero rows but %d zero columns, each algebraic equation needs an algebraic component. Exiting program..\n", nrows, ncols);
+        exit(EXIT_FAILURE);
+    }
+
+    if(nrows == 0) {
+        return;
+    }
+
+    gsl_matrix *jac = gsl_matrix_alloc(nrows, nrows);
+    gsl_permutation *perm = gsl_permutation_alloc(nrows);
+    double rhs[nrows];
+    gsl_vector_view correction = gsl_vector_view_array(rhs, nrows);
+    int iteration;
+    bool converged = false;
+
+    for (iteration = 1; iteration <= DAE_MAXNEWTON && converged == false; ++iteration) {
+
+        derivative(t, y, f);
+
+        // Jacobian of the algebraic equations by the algebraic components
+        for (int col = 0; col < nrows; ++col) {
+            int var = cols[col];
+            double saved = y[var];
+            delta = sqrt(UROUND * FMAX(1.0e-5, fabs(saved)));
+            y[var] = saved + delta;
+            derivative(t, y, fperturbed);
+            y[var] = saved;
+            for (int row = 0; row < nrows; ++row) {
+                gsl_matrix_set(jac, row, col, (fperturbed[rows[row]] - f[rows[row]]) / delta);
+            }
+        }
+        options -> stats.rhsCalls += nrows + 1;
+
+        gsl_linalg_LU_decomp(jac, perm, &signum);
+        for (int row = 0; row < nrows; ++row) {
+            if(gsl_matrix_get(jac, row, row) == 0.0) {
+                fprintf(stderr, "The algebraic equations are singular in the algebraic components, the DAE is not of index 1. Exiting program..\n");
+                exit(EXIT_FAILURE);
+            }
+            rhs[row] = -f[rows[row]];
+        }
+        gsl_linalg_LU_svx(jac, perm, &correction.vector);
+
+        converged = true;
+        for (int col = 0; col < nrows; ++col) {
+            step = rhs[col];
+            y[cols[col]] += step;
+            converged = converged && (fabs(step) <= 1.0e-10 * (1.0 + fabs(y[cols[col]])));
+        }
+    }
+
+    gsl_matrix_free(jac);
+    gsl_permutation_free(perm);
+
+    if(converged == false) {
+        fprintf(stderr, "No consistent initial values found for the algebraic components in %d Newton iterations. Exiting program..\n", DAE_MAXNEWTON);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("\t- Consistent initial values of %d algebraic components after %d Newton iterations\n", nrows, iteration - 1);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Newton-Krylov
+//
+// ----------------------------------------------------------------------------
+
+// preconditioner registered by setPreconditioner()
+static void (*precSetup)(const double *t, const double y[], double hg) = NULL;
+static void (*precSolve)(const double r[], double z[]) = NULL;
+
+// Registers the preconditioner of the Newton-Krylov iterations: setup(t, y, hg) prepares
+// P ~ I - hg df/dy at (t, y) when the Jacobian would be re-evaluated or hg has moved,
+// solve(r, z) returns z = P^-1 r (NULL setup for a fixed P).
+void setPreconditioner(void (*fSetup)(const double *t, const double y[], double hg), void (*fSolve)(const double r[], double z[])){
+
+    precSetup = fSetup;
+    precSolve = fSolve;
+}
+
+bool hasPreconditioner(void){
+
+    return precSolve != NULL;
+}
+
+// out = (I - hg J) v with J v = (f(t, Z + sigma v) - f(t, Z)) / sigma, the increment
+// sqrt(uround) (1 + ||Z||) / ||v|| of Brown and Saad; a taylorModel takes the exact J v
+// of one tangent on its tape
+static void krylovApply(void (*f)(const double *t, const double y[], double ydot[]), const double *t, const double Z[], const double fz[], double hg, double znorm, const double v[], double out[], int NSYS){
+
+    double Zp[NSYS], fp[NSYS], vnorm = 0.0, sigma;
+
+    if(f == taylorDerivative) {
+        double jv[NSYS];
+        taylorTangents(getTaylorModel(), *t, Z, v, 1, fp, jv);
+        for (int var = 0; var < NSYS; ++var) {
+            out[var] = v[var] - hg * jv[var];
+        }
+        return;
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        vnorm += v[var] * v[var];
+    }
+    vnorm = sqrt(vnorm);
+
+    if(vnorm == 0.0) {
+        for (int var = 0; var < NSYS; ++var) {
+            out[var] = 0.0;
+        }
+        return;
+    }
+
+    sigma = sqrt(UROUND) * (1.0 + znorm) / vnorm;
+    for (int var = 0; var < NSYS; ++var) {
+        Zp[var] = Z[var] + sigma * v[var];
+    }
+    f(t, Zp, fp);
+
+    for (int var = 0; var < NSYS; ++var) {
+        out[var] = v[var] - hg * (fp[var] - fz[var]) / sigma;
+    }
+}
+
+// Right-preconditioned GMRES for (I - hg J) x = b, J = df/dy at (t, Z) with fz = f(t, Z),
+// never formed. Vectors are scaled by 1/scal so the inner products weigh the components
+// as the error control does; the iteration stops once the weighted RMS residual is
+// below tol or after krylovSize iterations on each of KRYLOV_RESTARTS + 1 cycles. Keeps
+// krylovSize + 3 vectors of NSYS. Counts one derivative evaluation per product.
+static void krylovSolve(void (*f)(const double *t, const double y[], double ydot[]), const double *t, const double Z[], const double fz[], double hg, const double b[], double x[], const double scal[], double tol, esdirkWork *work, odeStats *stats, int NSYS){
+
+    int m = work -> krylovSize, used;
+    double *V = work -> krylov, *w = &work -> krylov[(m + 1) * NSYS], *z = &work -> krylov[(m + 2) * NSYS];
+    double H[(m + 1) * m], cs[m], sn[m], g[m + 1], coef[m];
+    double znorm = 0.0, beta, hnext, rootN = sqrt((double) NSYS), r;
+    bool converged = false;
+
+    for (int var = 0; var < NSYS; ++var) {
+        znorm += Z[var] * Z[var];
+        x[var] = 0.0;
+    }
+    znorm = sqrt(znorm);
+
+    for (int cycle = 0; cycle <= KRYLOV_RESTARTS && converged == false; ++cycle) {
+
+        // Block 1 Calculations: scaled residual b - (I - hg J) x of the cycle
+        if(cycle > 0) {
+            krylovApply(f, t, Z, fz, hg, znorm, x, w, NSYS);
+            stats -> rhsCalls += 1;
+        }
+        beta = 0.0;
+        for (int var = 0; var < NSYS; ++var) {
+            V[var] = (b[var] - ((cycle > 0) ? w[var] : 0.0)) / scal[var];
+            beta += V[var] * V[var];
+        }
+        beta = sqrt(beta);
+
+        if(beta / rootN <= tol) {
+            break;
+        }
+        for (int var = 0; var < NSYS; ++var) {
+            V[var] /= beta;
+        }
+        g[0] = beta;
+
+        for (used = 0; used < m && converged == false; ++used) {
+
+            int j = used;
+            double *vj = &V[j * NSYS], *vnext = &V[(j + 1) * NSYS];
+
+            // Block 2 Calculations: w = D (I - hg J) P^-1 D^-1 v_j
+            for (int var = 0; var < NSYS; ++var) {
+                w[var] = vj[var] * scal[var];
+            }
+            if(precSolve != NULL) {
+                precSolve(w, z);
+            } else {
+                for (int var = 0; var < NSYS; ++var) {
+                    z[var] = w[var];
+                }
+            }
+            krylovApply(f, t, Z, fz, hg, znorm, z, w, NSYS);
+            stats -> rhsCalls += 1;
+            stats -> krylovIterations += 1;
+            for (int var = 0; var < NSYS; ++var) {
+                w[var] /= scal[var];
+            }
+
+            // Block 3 Calculations: modified Gram-Schmidt against the basis
+            for (int i = 0; i <= j; ++i) {
+                double dot = 0.0;
+                for (int var = 0; var < NSYS; ++var) {
+                    dot += w[var] * V[i * NSYS + var];
+                }
+                H[i * m + j] = dot;
+                for (int var = 0; var < NSYS; ++var) {
+                    w[var] -= dot * V[i * NSYS + var];
+                }
+            }
+            hnext = 0.0;
+            for (int var = 0; var < NSYS; ++var) {
+                hnext += w[var] * w[var];
+            }
+            hnext = sqrt(hnext);
+            for (int var = 0; hnext > 0.0 && var < NSYS; ++var) {
+                vnext[var] = w[var] / hnext;
+            }
+
+            // Block 4 Calculations: Givens rotations keep H upper triangular, g the residual
+            for (int i = 0; i < j; ++i) {
+                double upper = H[i * m + j], lower = H[(i + 1) * m + j];
+                H[i * m + j] = cs[i] * upper + sn[i] * lower;
+                H[(i + 1) * m + j] = -sn[i] * upper + cs[i] * lower;
+            }
+            r = hypot(H[j * m + j], hnext);
+            cs[j] = H[j * m + j] / r;
+            sn[j] = hnext / r;
+            H[j * m + j] = r;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+
+            converged = (fabs(g[j + 1]) / rootN <= tol || hnext == 0.0);
+        }
+
+        // Block 5 Calculations: x += P^-1 D^-1 V y with H y = g
+        for (int i = used - 1; i >= 0; --i) {
+            coef[i] = g[i];
+            for (int k = i + 1; k < used; ++k) {
+                coef[i] -= H[i * m + k] * coef[k];
+            }
+            coef[i] /= H[i * m + i];
+        }
+        for (int var = 0; var < NSYS; ++var) {
+            w[var] = 0.0;
+            for (int i = 0; i < used; ++i) {
+                w[var] += coef[i] * V[i * NSYS + var];
+            }
+            w[var] *= scal[var];
+        }
+        if(precSolve != NULL) {
+            precSolve(w, z);
+        } else {
+            for (int var = 0; var < NSYS; ++var) {
+                z[var] = w[var];
+            }
+        }
+        for (int var = 0; var < NSYS; ++var) {
+            x[var] += z[var];
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            ESDIRK
+//
+// ----------------------------------------------------------------------------
+
+// Method ID = 17
+// TR-BDF2 (Bank et al., embedded pair of Hosea & Shampine): trapezoidal rule to
+// t + gamma h, then BDF2 to t + h, gamma = 2 - sqrt(2). L-stable, order 2 with an
+// embedded order 3 solution.
+static const double TRBDF2_c[] = {0.0, 0.58578643762690495119, 1.0};
+static const double TRBDF2_A[] = {
+    0.0, 0.0, 0.0,
+    0.29289321881345247560, 0.29289321881345247560, 0.0,
+    0.35355339059327376220, 0.35355339059327376220, 0.29289321881345247560
+};
+static const double TRBDF2_b[] = {0.35355339059327376220, 0.35355339059327376220, 0.29289321881345247560};
+static const double TRBDF2_bhat[] = {0.21548220313557541260, 0.68688672392660709553, 0.09763107293781749187};
+
+const esdirkTableau TRBDF2_tableau = {3, 0.29289321881345247560, TRBDF2_c, TRBDF2_A, TRBDF2_b, TRBDF2_bhat, NULL};
+
+// Method ID = 18
+// ESDIRK4(3)6L[2]SA (Kennedy & Carpenter), the implicit part of ARK4(3)6L: six stages,
+// gamma = 1/4, L-stable and stiffly accurate, order 4 with an embedded order 3 solution.
+static const double ESDIRK43_c[] = {0.0, 0.5, 0.332, 0.62, 0.85, 1.0};
+static const double ESDIRK43_A[] = {
+    0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+    0.25, 0.25, 0.0, 0.0, 0.0, 0.0,
+    8611.0/62500.0, -1743.0/31250.0, 0.25, 0.0, 0.0, 0.0,
+    5012029.0/34652500.0, -654441.0/2922500.0, 174375.0/388108.0, 0.25, 0.0, 0.0,
+    15267082809.0/155376265600.0, -71443401.0/120774400.0, 730878875.0/902184768.0, 2285395.0/8070912.0, 0.25, 0.0,
+    82889.0/524892.0, 0.0, 15625.0/83664.0, 69875.0/102672.0, -2260.0/8211.0, 0.25
+};
+static const double ESDIRK43_b[] = {82889.0/524892.0, 0.0, 15625.0/83664.0, 69875.0/102672.0, -2260.0/8211.0, 0.25};
+static const double ESDIRK43_bhat[] = {4586570599.0/29645900160.0, 0.0, 178811875.0/945068544.0, 814220225.0/1159782912.0, -3700637.0/11593932.0, 61727.0/225920.0};
+
+const esdirkTableau ESDIRK43_tableau = {6, 0.25, ESDIRK43_c, ESDIRK43_A, ESDIRK43_b, ESDIRK43_bhat, NULL};
+
+// Method ID = 23
+// ARK4(3)6L[2]SA (Kennedy & Carpenter 2003): ESDIRK4(3)6L for the stiff part paired with
+// a six stage explicit method for the non-stiff part, same c, b and bhat. Order 4 with
+// an embedded order 3 solution.
+static const double ARK43_Ae[] = {
+    0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+    0.5, 0.0, 0.0, 0.0, 0.0, 0.0,
+    13861.0/62500.0, 6889.0/62500.0, 0.0, 0.0, 0.0, 0.0,
+    -116923316275.0/2393684061468.0, -2731218467317.0/15368042101831.0, 9408046702089.0/11113171139209.0, 0.0, 0.0, 0.0,
+    -451086348788.0/2902428689909.0, -2682348792572.0/7519795681897.0, 12662868775082.0/11960479115383.0, 3355817975965.0/11060851509271.0, 0.0, 0.0,
+    647845179188.0/3216320057751.0, 73281519250.0/8382639484533.0, 552539513391.0/3454668386233.0, 3354512671639.0/8306763924573.0, 4040.0/17871.0, 0.0
+};
+
+const esdirkTableau ARK43_tableau = {6, 0.25, ESDIRK43_c, ESDIRK43_A, ESDIRK43_b, ESDIRK43_bhat, ARK43_Ae};
+
+// explicit and implicit parts of an IMEX model, f = fExplicit + fImplicit
+static void (*imexExplicit)(const double *t, const double y[], double ydot[]) = NULL;
+static void (*imexImplicit)(const double *t, const double y[], double ydot[]) = NULL;
+static int imexNSYS = 0;
+
+// Registers the split right hand side before callODESolver(): the additive method
+// integrates fImplicit implicitly and fExplicit explicitly, the other methods their sum.
+void setIMEXModel(void (*fExplicit)(const double *t, const double y[], double ydot[]), void (*fImplicit)(const double *t, const double y[], double ydot[]), int NSYS){
+
+    imexExplicit = fExplicit;
+    imexImplicit = fImplicit;
+    imexNSYS = NSYS;
+}
+
+bool hasIMEXModel(void){
+
+    return imexExplicit != NULL && imexImplicit != NULL;
+}
+
+// f = fExplicit + fImplicit
+void imexDerivative(const double *t, const double y[], double ydot[]){
+
+    int NSYS = imexNSYS;
+    double part[NSYS];
+
+    imexExplicit(t, y, ydot);
+    imexImplicit(t, y, part);
+
+    for (int var = 0; var < NSYS; ++var) {
+        ydot[var] += part[var];
+    }
+}
+
+// krylovSize > 0 selects Newton-Krylov, storing the Arnoldi basis instead of matrices
+esdirkWork * esdirkAlloc(const esdirkTableau *tableau, int NSYS, int krylovSize){
+
+    esdirkWork *work = (esdirkWork *) malloc(sizeof(esdirkWork));
+
+    work -> tableau = tableau;
+    work -> krylovSize = krylovSize;
+    work -> jac = NULL; work -> M = NULL; work -> perm = NULL; work -> krylov = NULL;
+    if(krylovSize > 0) {
+        work -> krylov = (double *) malloc(sizeof(double) * (krylovSize + 3) * NSYS);
+    } else {
+        work -> jac = gsl_matrix_alloc(NSYS, NSYS);
+        work -> M = gsl_matrix_alloc(NSYS, NSYS);
+        work -> perm = gsl_permutation_alloc(NSYS);
+    }
+    work -> hLU = 0.0;
+    work -> jacAge = 0;
+    work -> jacValid = false; work -> luValid = false;
+
+    return work;
+}
+
+void esdirkFree(esdirkWork *work){
+
+    if(work == NULL) {
+        return;
+    }
+
+    if(work -> krylov == NULL) {
+        gsl_matrix_free(work -> jac);
+        gsl_matrix_free(work -> M);
+        gsl_permutation_free(work -> perm);
+    }
+    free(work -> krylov);
+    free(work);
+}
+
+// Trial step of an ESDIRK method, selected by options -> esdirk -> tableau. K[i * NSYS]
+// holds the stage derivatives, K1 = f(t, y) supplied by the caller; the last stage is
+// f(t + h, ytemp) for the stiffly accurate tableaux (FSAL). Every implicit stage
+// Z = y + h sum(a_ij K_j) + h gamma f(Z) is solved by simplified Newton iteration with
+// the one LU of I - h gamma J. The Jacobian is kept across steps and refreshed only
+// when Newton fails with an old one; a failure with a fresh Jacobian returns HUGE_VAL so
+// the controller retries with a smaller step. Returns the error norm of b - bhat.
+// Additive tableaux iterate on the implicit part of the IMEX model only: its stage
+// derivatives go to stages 1 .. s, those of the explicit part to stages s + 1 .. 2s and
+// enter the known part of the later stages, so J and Newton cover the stiff part alone.
+// Newton-Krylov takes each correction from GMRES at the current iterate to 0.05 kappa,
+// as CVODE; the registered preconditioner is set up in place of the Jacobian, and again
+// when h gamma moves by 30%.
+double ESDIRK(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, odeOptions *options){
+
+    // {'maxIter': Newton iterations per stage, 'kappa': Newton tolerance relative to the error weights }
+    static int maxIter = 7, maxJacAge = 50;
+    static double kappa = 0.03, maxRate = 0.9, krylovTol = 0.05, precChange = 0.3;
+
+    int NSYS = options -> NSYS, signum;
+    esdirkWork *work = options -> esdirk;
+    const esdirkTableau *tab = work -> tableau;
+    int s = tab -> stages;
+    bool additive = (tab -> Ae != NULL), krylov = (work -> krylovSize > 0);
+    void (*implicitPart)(const double *t, const double y[], double ydot[]) = additive ? imexImplicit : derivative;
+    double *K = options -> stages, *KE = NULL, hg = step * tab -> gamma;
+    double known[NSYS], Z[NSYS], fz[NSYS], delta[NSYS], scal[NSYS], correction[NSYS], tstage;
+    double dnorm, dold, rate;
+    bool converged = true, fresh;
+
+    // Newton weights from the tolerances at the start of the step
+    for (int var = 0; var < NSYS; ++var) {
+        scal[var] = (norm != NULL) ? norm -> absWeight[var] + norm -> relWeight[var] * fabs(y[var])
+                  : options -> relTol[var] * (fabs(y[var]) + fabs(step * K[var]) + 1.0e-30);
+    }
+
+    // first stage split into its implicit and explicit parts, stages[0] keeps f(t, y)
+    if(additive) {
+        KE = &options -> stages[(s + 1) * NSYS];
+        implicitPart(t, y, &K[NSYS]);
+        options -> stats.rhsCalls += 1;
+        for (int var = 0; var < NSYS; ++var) {
+            KE[var] = K[var] - K[NSYS + var];
+        }
+        K = &options -> stages[NSYS];
+    }
+
+    if(work -> jacAge >= maxJacAge) {
+        work -> jacValid = false;
+    }
+    work -> jacAge += 1;
+
+    while(true) {
+
+        // without a preconditioner the Krylov iterations have nothing to refresh
+        fresh = (work -> jacValid == false) || (krylov && precSetup == NULL);
+        if(fresh && krylov) {
+            work -> jacValid = true;
+            work -> jacAge = 0;
+            work -> luValid = false;
+        } else if(fresh) {
+            // K1 may come from the last stage of the previous step, (Z - known) / (h gamma)
+            // carries the Newton error magnified by 1 / (h gamma): difference against f(t, y)
+            implicitPart(t, y, fz);
+            options -> stats.rhsCalls += jacobianFD(implicitPart, t, y, fz, work -> jac, NSYS) + 1;
+            options -> stats.jacobians += 1;
+            work -> jacValid = true;
+            work -> jacAge = 0;
+            work -> luValid = false;
+        }
+
+        // preconditioner at the step start, kept while h gamma stays close
+        if(krylov && (work -> luValid == false || fabs(step / work -> hLU - 1.0) > precChange)) {
+            if(precSetup != NULL) {
+                precSetup(t, y, hg);
+                options -> stats.preconditionerSetups += 1;
+            }
+            work -> hLU = step;
+            work -> luValid = true;
+        }
+
+        // one Newton matrix for every stage
+        if(krylov == false && (work -> luValid == false || step != work -> hLU)) {
+            for (int row = 0; row < NSYS; ++row) {
+                for (int col = 0; col < NSYS; ++col) {
+                    gsl_matrix_set(work -> M, row, col, (row == col ? 1.0 : 0.0) - hg * gsl_matrix_get(work -> jac, row, col));
+                }
+            }
+            gsl_linalg_LU_decomp(work -> M, work -> perm, &signum);
+            options -> stats.decompositions += 1;
+            work -> hLU = step;
+            work -> luValid = true;
+        }
+
+        for (int i = 1; i < s && converged; ++i) {
+
+            tstage = *t + tab -> c[i] * step;
+
+            // explicit part of the stage, and the previous stage derivative as predictor
+            for (int var = 0; var < NSYS; ++var) {
+                known[var] = y[var];
+                for (int j = 0; j < i; ++j) {
+                    known[var] += step * tab -> A[i * s + j] * K[j * NSYS + var];
+                    if(additive) {
+                        known[var] += step * tab -> Ae[i * s + j] * KE[j * NSYS + var];
+                    }
+                }
+                Z[var] = known[var] + hg * K[(i - 1) * NSYS + var];
+            }
+
+            dold = 0.0;
+            converged = false;
+
+            for (int iter = 0; iter < maxIter; ++iter) {
+
+                implicitPart(&tstage, Z, fz);
+                options -> stats.rhsCalls += 1;
+
+                for (int var = 0; var < NSYS; ++var) {
+                    delta[var] = known[var] + hg * fz[var] - Z[var];
+                }
+
+                if(krylov) {
+                    krylovSolve(implicitPart, &tstage, Z, fz, hg, delta, correction, scal, krylovTol * kappa, work, &options -> stats, NSYS);
+                    for (int var = 0; var < NSYS; ++var) {
+                        delta[var] = correction[var];
+                    }
+                } else {
+                    gsl_vector_view solved = gsl_vector_view_array(delta, NSYS);
+                    gsl_linalg_LU_svx(work -> M, work -> perm, &solved.vector);
+                }
+
+                dnorm = 0.0;
+                for (int var = 0; var < NSYS; ++var) {
+                    Z[var] += delta[var];
+                    dnorm += (delta[var] / scal[var]) * (delta[var] / scal[var]);
+                }
+                dnorm = sqrt(dnorm / NSYS);
+
+                if(iter == 0) {
+                    converged = (dnorm <= 0.1 * kappa);
+                } else {
+                    rate = dnorm / dold;
+                    if(rate >= maxRate) {
+                        break;
+                    }
+                    converged = (rate / (1.0 - rate) * dnorm <= kappa);
+                }
+
+                if(converged) {
+                    break;
+                }
+                dold = FMAX(dnorm, UROUND);
+            }
+
+            // stage derivative from the converged stage, no extra derivative evaluation
+            for (int var = 0; var < NSYS; ++var) {
+                K[i * NSYS + var] = (Z[var] - known[var]) / hg;
+            }
+            if(additive && converged) {
+                imexExplicit(&tstage, Z, &KE[i * NSYS]);
+                options -> stats.rhsCalls += 1;
+            }
+        }
+
+        if(converged) {
+            break;
+        }
+
+        // Newton failed: retry with a fresh Jacobian, or let the controller reduce the step;
+        // a fresh Jacobian stays valid and the shorter step refactors only the matrix
+        if(fresh) {
+            return HUGE_VAL;
+        }
+        work -> jacValid = false;
+        converged = true;
+    }
+
+    // solution and embedded error estimate
+    double ratio, err[NSYS], sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int var = 0; var < NSYS; ++var) {
+        ytemp[var] = y[var];
+        err[var] = 0.0;
+        for (int i = 0; i < s; ++i) {
+            double Ki = K[i * NSYS + var] + (additive ? KE[i * NSYS + var] : 0.0);
+            ytemp[var] += step * tab -> b[i] * Ki;
+            err[var] += step * (tab -> b[i] - tab -> bhat[i]) * Ki;
+        }
+    }
+
+    // the explicit stages leave the stiff components off their slow manifold, which the
+    // implicit stage derivatives amplify by the stiffness: filter the estimate through
+    // (I - h gamma J)^-1 as Radau does, leaving the non-stiff components unchanged
+    if(additive && krylov) {
+        krylovSolve(implicitPart, t, y, K, hg, err, correction, scal, krylovTol, work, &options -> stats, NSYS);
+        for (int var = 0; var < NSYS; ++var) {
+            err[var] = correction[var];
+        }
+    } else if(additive) {
+        gsl_vector_view filtered = gsl_vector_view_array(err, NSYS);
+        gsl_linalg_LU_svx(work -> M, work -> perm, &filtered.vector);
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        if(norm != NULL) {
+            ratio = err[var] / (norm -> absWeight[var] + norm -> relWeight[var] * FMAX(fabs(y[var]), fabs(ytemp[var])));
+            sumSquares += ratio * ratio;
+            maxRatio = FMAX(maxRatio, fabs(ratio));
+        }
+    }
+
+    if(norm == NULL) {
+        return 0.0;
+    }
+
+    return (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Rosenbrock
+//
+// ----------------------------------------------------------------------------
+
+// ROS34PW2 of Rang and Angermann (2005): 4 stages, order 3 with an embedded order 2
+// solution, stiffly accurate, L-stable, and a W-method that keeps its order with an
+// approximate Jacobian. Coefficients alpha_ij, gamma_ij (gamma on the diagonal), b, bhat.
+static const double ROS_gamma = 0.435866521508459;
+static const double ROS_alpha[] = {
+    0.0, 0.0, 0.0, 0.0,
+    0.87173304301691801, 0.0, 0.0, 0.0,
+    0.84457060015369423, -0.11299064236484185, 0.0, 0.0,
+    0.0, 0.0, 1.0, 0.0
+};
+static const double ROS_Gamma[] = {
+    0.435866521508459, 0.0, 0.0, 0.0,
+    -0.87173304301691801, 0.435866521508459, 0.0, 0.0,
+    -0.90338057013044082, 0.054180672388095326, 0.435866521508459, 0.0,
+    0.24212380706095346, -1.2232505839045147, 0.54526025533510214, 0.435866521508459
+};
+static const double ROS_b[] = {0.24212380706095346, -1.2232505839045147, 1.5452602553351020, 0.435866521508459};
+static const double ROS_bhat[] = {0.37810903145819369, -0.096042292212423178, 0.5, 0.2179332607542295};
+
+// The work holds the method in the form of Hairer and Wanner (IV.7.25), one banded
+// solve per stage and no products with J: a = alpha Gamma^-1, c = 1/gamma - Gamma^-1,
+// m = b Gamma^-1. The Jacobian has `lower` subdiagonals and `upper` superdiagonals;
+// mixed keeps its LU in single precision.
+rosenbrockWork * rosenbrockAlloc(int NSYS, int lower, int upper, bool mixed){
+
+    rosenbrockWork *work = (rosenbrockWork *) malloc(sizeof(rosenbrockWork));
+    int s = ROS_STAGES;
+    double inverse[s * s];
+
+    work -> jac = bandAlloc(NSYS, lower, upper);
+    work -> mixed = mixed;
+    work -> M = NULL; work -> Mf = NULL; work -> rf = NULL; work -> b = NULL; work -> residual = NULL;
+    if(mixed) {
+        work -> Mf = bandAllocFloat(NSYS, lower, lower + upper);
+        work -> rf = (float *) malloc(sizeof(float) * NSYS);
+        work -> b = (double *) malloc(sizeof(double) * NSYS);
+        work -> residual = (double *) malloc(sizeof(double) * NSYS);
+    } else {
+        work -> M = bandAlloc(NSYS, lower, lower + upper);
+    }
+    work -> pivot = (int *) malloc(sizeof(int) * NSYS);
+    work -> ft = (double *) malloc(sizeof(double) * NSYS);
+    work -> U = (double *) malloc(sizeof(double) * s * NSYS);
+
+    // Gamma^-1 by forward substitution, column by column
+    for (int col = 0; col < s; ++col) {
+        for (int row = 0; row < s; ++row) {
+            double sum = (row == col) ? 1.0 : 0.0;
+            for (int k = 0; k < row; ++k) {
+                sum -= ROS_Gamma[row * s + k] * inverse[k * s + col];
+            }
+            inverse[row * s + col] = sum / ROS_Gamma[row * s + row];
+        }
+    }
+
+    for (int i = 0; i < s; ++i) {
+        work -> alpha[i] = 0.0; work -> gammaSum[i] = 0.0;
+        work -> m[i] = 0.0; work -> e[i] = 0.0;
+        for (int j = 0; j < s; ++j) {
+            work -> alpha[i] += ROS_alpha[i * s + j];
+            work -> gammaSum[i] += ROS_Gamma[i * s + j];
+            work -> m[i] += ROS_b[j] * inverse[j * s + i];
+            work -> e[i] += (ROS_b[j] - ROS_bhat[j]) * inverse[j * s + i];
+            work -> a[i * s + j] = 0.0;
+            for (int k = 0; k < s; ++k) {
+                work -> a[i * s + j] += ROS_alpha[i * s + k] * inverse[k * s + j];
+            }
+            work -> c[i * s + j] = ((i == j) ? 1.0 / ROS_gamma : 0.0) - inverse[i * s + j];
+        }
+    }
+
+    work -> hLU = 0.0; work -> jacTime = 0.0; work -> tTrial = NAN;
+    work -> jacAge = 0;
+    work -> jacValid = false; work -> luValid = false;
+
+    return work;
+}
+
+void rosenbrockFree(rosenbrockWork *work){
+
+    if(work == NULL) {
+        return;
+    }
+
+    bandFree(work -> jac);
+    bandFree(work -> M);
+    bandFreeFloat(work -> Mf);
+    free(work -> rf);
+    free(work -> b);
+    free(work -> residual);
+    free(work -> pivot);
+    free(work -> ft);
+    free(work -> U);
+    free(work);
+}
+
+// Solves (I/(h gamma) - J) x = b in place with the LU of the step. In mixed precision
+// the single precision solve is refined by x += (LU)^-1 (b - (I/(h gamma) - J) x) with
+// the residual in double, each residual and the matrix scaled to unit size so single
+// precision neither overflows nor underflows, until the correction is below tol
+// relative to x or after ROS_REFINEMENTS sweeps. Refinement recovers double precision accuracy as long
+// as the condition number stays well below 1 / FLT_EPSILON.
+static void rosenbrockSolve(rosenbrockWork *work, double step, double x[], double tol, odeStats *stats, int NSYS){
+
+    if(work -> mixed == false) {
+        bandSolve(work -> M, work -> pivot, x);
+        return;
+    }
+
+    double *b = work -> b, *r = work -> residual, diagonal = 1.0 / (step * ROS_gamma);
+    float *rf = work -> rf;
+
+    for (int var = 0; var < NSYS; ++var) {
+        b[var] = x[var];
+        r[var] = x[var];
+        x[var] = 0.0;
+    }
+
+    for (int sweep = 0; sweep <= ROS_REFINEMENTS; ++sweep) {
+
+        double rmax = 0.0, dmax = 0.0, xmax = 0.0;
+
+        // Block 1 Calculations: residual in double, the first one is b itself
+        if(sweep > 0) {
+            bandMultiply(work -> jac, x, r);
+            for (int var = 0; var < NSYS; ++var) {
+                r[var] = b[var] - diagonal * x[var] + r[var];
+            }
+            stats -> refinements += 1;
+        }
+        for (int var = 0; var < NSYS; ++var) {
+            rmax = FMAX(rmax, fabs(r[var]));
+        }
+        if(rmax == 0.0) {
+            break;
+        }
+
+        // Block 2 Calculations: correction in single precision
+        for (int var = 0; var < NSYS; ++var) {
+            rf[var] = (float) (r[var] / rmax);
+        }
+        bandSolveFloat(work -> Mf, work -> pivot, rf);
+        for (int var = 0; var < NSYS; ++var) {
+            x[var] += rmax * work -> luScale * rf[var];
+            dmax = FMAX(dmax, rmax * work -> luScale * fabs(rf[var]));
+            xmax = FMAX(xmax, fabs(x[var]));
+        }
+
+        if(sweep > 0 && dmax <= tol * xmax) {
+            break;
+        }
+    }
+}
+
+// Trial step of ROS34PW2 on the banded Jacobian of options -> rosenbrock, f(t, y)
+// supplied by the caller in stages[0]. Each stage solves
+//     (I/(h gamma) - J) U_i = f(t + alpha_i h, y + sum a_ij U_j) + sum (c_ij/h) U_j + gamma_i h df/dt
+// with the one banded LU of the step, O(NSYS (lower + upper) lower) to decompose and
+// O(NSYS (2 lower + upper)) per solve. The Jacobian is kept for up to maxJacAge trial
+// steps and refreshed when a trial at the same t is retried with an older one; a
+// singular matrix returns HUGE_VAL so the controller reduces the step. Mixed precision
+// refines every stage solve to the smallest relative tolerance: an unrefined solve is
+// an exact one with a perturbed Jacobian, which the W-method absorbs, so refinement only
+// has to keep the effective Jacobian close. Returns the error norm of the embedded
+// solution.
+double ROS34PW2(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double step, const errorNorm *norm, odeOptions *options){
+
+    // {'maxJacAge': trial steps on one Jacobian }
+    static int maxJacAge = 20;
+
+    int NSYS = options -> NSYS, s = ROS_STAGES;
+    rosenbrockWork *work = options -> rosenbrock;
+    bandMatrix *J = work -> jac, *M = work -> M;
+    bandMatrixFloat *Mf = work -> Mf;
+    double *dydt = options -> stages, *U = work -> U;
+    double Y[NSYS], err[NSYS], tstage, refineTol = options -> relTol[0];
+
+    for (int var = 1; work -> mixed && var < NSYS; ++var) {
+        refineTol = FMIN(refineTol, options -> relTol[var]);
+    }
+
+    // a retried trial follows a rejection: an old Jacobian may be to blame
+    if(work -> jacAge >= maxJacAge || (work -> tTrial == *t && work -> jacTime != *t)) {
+        work -> jacValid = false;
+    }
+    work -> tTrial = *t;
+
+    if(work -> jacValid == false) {
+        double delta = sqrt(UROUND * FMAX(1.0e-5, fabs(*t)));
+        tstage = *t + delta;
+
+        options -> stats.rhsCalls += jacobianBandFD(derivative, t, y, dydt, J) + 1;
+        options -> stats.jacobians += 1;
+
+        derivative(&tstage, y, Y);
+        for (int var = 0; var < NSYS; ++var) {
+            work -> ft[var] = (Y[var] - dydt[var]) / delta;
+        }
+
+        work -> jacTime = *t;
+        work -> jacAge = 0;
+        work -> jacValid = true;
+        work -> luValid = false;
+    }
+    work -> jacAge += 1;
+
+    if(work -> luValid == false || step != work -> hLU) {
+        // the single precision copy is scaled to unit size, see bandLUFloat()
+        double largest = 1.0 / (step * ROS_gamma);
+        for (long entry = 0; work -> mixed && entry < (long) NSYS * J -> width; ++entry) {
+            largest = FMAX(largest, fabs(J -> data[entry]) + 1.0 / (step * ROS_gamma));
+        }
+        work -> luScale = 1.0 / largest;
+
+        if(work -> mixed) {
+            memset(Mf -> data, 0, sizeof(float) * (size_t) NSYS * Mf -> width);
+        } else {
+            bandZero(M);
+        }
+        for (int row = 0; row < NSYS; ++row) {
+            int first = (row - J -> lower > 0) ? row - J -> lower : 0, last = (row + J -> upper < NSYS - 1) ? row + J -> upper : NSYS - 1;
+            for (int col = first; col <= last; ++col) {
+                if(work -> mixed) {
+                    BAND(Mf, row, col) = (float) ((((row == col) ? 1.0 / (step * ROS_gamma) : 0.0) - BAND(J, row, col)) * work -> luScale);
+                } else {
+                    BAND(M, row, col) = ((row == col) ? 1.0 / (step * ROS_gamma) : 0.0) - BAND(J, row, col);
+                }
+            }
+        }
+        options -> stats.decompositions += 1;
+        work -> hLU = step;
+        work -> luValid = ((work -> mixed ? bandLUFloat(Mf, work -> pivot) : bandLU(M, work -> pivot)) == 0);
+        if(work -> luValid == false) {
+            return HUGE_VAL;
+        }
+    }
+
+    for (int i = 0; i < s; ++i) {
+
+        double *Ui = &U[i * NSYS];
+        tstage = *t + work -> alpha[i] * step;
+
+        // Block 1 Calculations: stage value and its derivative, f(t, y) for the first
+        if(i == 0) {
+            for (int var = 0; var < NSYS; ++var) {
+                Ui[var] = dydt[var];
+            }
+        } else {
+            for (int var = 0; var < NSYS; ++var) {
+                Y[var] = y[var];
+                for (int j = 0; j < i; ++j) {
+                    Y[var] += work -> a[i * s + j] * U[j * NSYS + var];
+                }
+            }
+            derivative(&tstage, Y, Ui);
+        }
+
+        // Block 2 Calculations: right hand side of the stage and the banded solve
+        for (int var = 0; var < NSYS; ++var) {
+            for (int j = 0; j < i; ++j) {
+                Ui[var] += work -> c[i * s + j] / step * U[j * NSYS + var];
+            }
+            Ui[var] += work -> gammaSum[i] * step * work -> ft[var];
+        }
+        rosenbrockSolve(work, step, Ui, refineTol, &options -> stats, NSYS);
+    }
+
+    // solution and embedded error estimate
+    double ratio, sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int var = 0; var < NSYS; ++var) {
+        ytemp[var] = y[var];
+        err[var] = 0.0;
+        for (int i = 0; i < s; ++i) {
+            ytemp[var] += work -> m[i] * U[i * NSYS + var];
+            err[var] += work -> e[i] * U[i * NSYS + var];
+        }
+    }
+
+    if(norm == NULL) {
+        return 0.0;
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        ratio = err[var] / (norm -> absWeight[var] + norm -> relWeight[var] * FMAX(fabs(y[var]), fabs(ytemp[var])));
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, fabs(ratio));
+    }
+
+    return (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+}
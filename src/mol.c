@@ -0,0 +1,301 @@
+/*
+* Method of lines: semi-discretization of reaction-advection-diffusion equations on 1D
+* and 2D cell-centred grids into the right hand side of a system of ODEs, with its
+* banded Jacobian assembled from the stencil.
+*/
+
+#include "mol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+
+#define UROUND 2.2e-16
+
+// grid and terms registered by setMOLModel()
+static molGrid grid;
+static bool registered = false;
+static void (*reaction)(const double *t, const double x[], const double u[], double r[]) = NULL;
+static void (*initial)(const double x[], double u[]) = NULL;
+
+// cell widths and stencil weights per component: west, east, south, north and centre
+static double hx, hy;
+static double wW[MOL_MAXCOMP], wE[MOL_MAXCOMP], wS[MOL_MAXCOMP], wN[MOL_MAXCOMP], wC[MOL_MAXCOMP];
+
+// ----------------------------------------------------------------------------
+//
+//                            Grid
+//
+// ----------------------------------------------------------------------------
+
+// Registers the grid of a method-of-lines model, the pointwise reaction R(t, x, u, r)
+// coupling the components of a node (NULL for none) and the initial values u(x) (NULL
+// keeps yInitCond). The model then replaces derivative() with NSYS = nx * ny * ncomp.
+void setMOLModel(const molGrid *model, void (*fReaction)(const double *t, const double x[], const double u[], double r[]), void (*fInitial)(const double x[], double u[])){
+
+    grid = *model;
+    grid.ny = (grid.dims == 1) ? 1 : grid.ny;
+
+    if((grid.dims != 1 && grid.dims != 2) || grid.nx < 1 || grid.ny < 1 || grid.ncomp < 1 || grid.ncomp > MOL_MAXCOMP) {
+        fprintf(stderr, "Method-of-lines grids have 1 or 2 dimensions, at least one cell per direction and 1 to %d components. Exiting program..\n", MOL_MAXCOMP);
+        exit(EXIT_FAILURE);
+    }
+    for (int side = 0; side < 2 * grid.dims; side += 2) {
+        if((grid.bc[side] == MOL_PERIODIC) != (grid.bc[side + 1] == MOL_PERIODIC)) {
+            fprintf(stderr, "Periodic boundary conditions apply to both sides of a direction. Exiting program..\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    hx = (grid.xb - grid.xa) / grid.nx;
+    hy = (grid.dims == 2) ? (grid.yb - grid.ya) / grid.ny : 1.0;
+
+    // -D u_xx and v u_x by central differences
+    for (int c = 0; c < grid.ncomp; ++c) {
+        double dx = grid.diffusion[c] / (hx * hx), ax = grid.velocity[0][c] / (2.0 * hx);
+        double dy = (grid.dims == 2) ? grid.diffusion[c] / (hy * hy) : 0.0, ay = (grid.dims == 2) ? grid.velocity[1][c] / (2.0 * hy) : 0.0;
+        wW[c] = dx + ax; wE[c] = dx - ax;
+        wS[c] = dy + ay; wN[c] = dy - ay;
+        wC[c] = -2.0 * (dx + dy);
+    }
+
+    reaction = fReaction;
+    initial = fInitial;
+    registered = true;
+}
+
+bool hasMOLModel(void){
+
+    return registered;
+}
+
+// unknowns of the model, its NSYS
+int molSize(void){
+
+    return grid.nx * grid.ny * grid.ncomp;
+}
+
+// subdiagonals and superdiagonals of the Jacobian: the neighbouring rows in 2D, the
+// neighbouring nodes in 1D; the corner entries of periodic boundaries fall outside
+void molBandwidth(int *lower, int *upper){
+
+    *lower = *upper = (grid.dims == 2) ? grid.nx * grid.ncomp : grid.ncomp;
+}
+
+// centre of the cell of a node
+void molNode(int node, double x[]){
+
+    x[0] = grid.xa + (node % grid.nx + 0.5) * hx;
+    x[1] = (grid.dims == 2) ? grid.ya + (node / grid.nx + 0.5) * hy : 0.0;
+}
+
+void molInitial(double y[]){
+
+    double x[2];
+
+    for (int node = 0; initial != NULL && node < grid.nx * grid.ny; ++node) {
+        molNode(node, x);
+        initial(x, &y[node * grid.ncomp]);
+    }
+}
+
+// value outside the boundary cell of side: inside is the boundary cell, opposite the
+// cell at the other end for periodic conditions
+static inline double ghostValue(int side, int c, double inside, double opposite){
+
+    switch(grid.bc[side]) {
+        case MOL_DIRICHLET: return 2.0 * grid.bcValue[side][c] - inside;
+        case MOL_NEUMANN: return inside + ((side < MOL_SOUTH) ? hx : hy) * grid.bcValue[side][c];
+        default: return opposite;
+    }
+}
+
+// d ghost / d inside for the non-periodic conditions
+static inline double ghostSlope(int side){
+
+    return (grid.bc[side] == MOL_DIRICHLET) ? -1.0 : 1.0;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Right Hand Side
+//
+// ----------------------------------------------------------------------------
+
+// Stencil over the nodes i0 to i1 - 1 of one grid row C, between the rows S and N (the
+// row itself in 1D, with zero weights). The inner nodes run branch-free with unit
+// stride for one component, the boundary columns take their ghost values.
+static void stencilRow(const double *restrict C, const double *restrict S, const double *restrict N, double *restrict out, int i0, int i1){
+
+    int nx = grid.nx, nc = grid.ncomp;
+    int first = (i0 > 1) ? i0 : 1, last = (i1 < nx - 1) ? i1 : nx - 1;
+
+    for (int c = 0; c < nc; ++c) {
+        double w = wW[c], e = wE[c], s = wS[c], n = wN[c], m = wC[c];
+
+        for (int k = first * nc + c; k < last * nc; k += nc) {
+            out[k] += w * C[k - nc] + e * C[k + nc] + s * S[k] + n * N[k] + m * C[k];
+        }
+
+        int edges[2] = {0, nx - 1};
+        for (int side = 0; side < ((nx > 1) ? 2 : 1); ++side) {
+            int i = edges[side];
+            if(i < i0 || i >= i1) {
+                continue;
+            }
+            int k = i * nc + c;
+            double west = (i > 0) ? C[k - nc] : ghostValue(MOL_WEST, c, C[k], C[(nx - 1) * nc + c]);
+            double east = (i < nx - 1) ? C[k + nc] : ghostValue(MOL_EAST, c, C[k], C[c]);
+            out[k] += w * west + e * east + s * S[k] + n * N[k] + m * C[k];
+        }
+    }
+}
+
+// Right hand side of the model, in place of derivative(): the reaction at every node,
+// then the stencil in blocks of MOL_BLOCK columns swept row by row, so the three rows
+// a block reads stay in cache for large nx.
+void molDerivative(const double *t, const double y[], double ydot[]){
+
+    int nx = grid.nx, ny = grid.ny, nc = grid.ncomp, row = nx * nc;
+    double ghostSouth[row], ghostNorth[row], x[2];
+
+    // Block 1 Calculations: reaction
+    for (int node = 0; node < nx * ny; ++node) {
+        if(reaction != NULL) {
+            molNode(node, x);
+            reaction(t, x, &y[node * nc], &ydot[node * nc]);
+            continue;
+        }
+        for (int c = 0; c < nc; ++c) {
+            ydot[node * nc + c] = 0.0;
+        }
+    }
+
+    // Block 2 Calculations: ghost rows beyond the south and north boundaries
+    for (int k = 0; grid.dims == 2 && k < row; ++k) {
+        ghostSouth[k] = ghostValue(MOL_SOUTH, k % nc, y[k], y[(ny - 1) * row + k]);
+        ghostNorth[k] = ghostValue(MOL_NORTH, k % nc, y[(ny - 1) * row + k], y[k]);
+    }
+
+    // Block 3 Calculations: stencil
+    for (int i0 = 0; i0 < nx; i0 += MOL_BLOCK) {
+        int i1 = (i0 + MOL_BLOCK < nx) ? i0 + MOL_BLOCK : nx;
+        for (int j = 0; j < ny; ++j) {
+            const double *C = &y[j * row];
+            const double *S = (grid.dims == 1) ? C : ((j > 0) ? C - row : ghostSouth);
+            const double *N = (grid.dims == 1) ? C : ((j < ny - 1) ? C + row : ghostNorth);
+            stencilRow(C, S, N, &ydot[j * row], i0, i1);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Jacobian
+//
+// ----------------------------------------------------------------------------
+
+// coupling of unknown r to its neighbour across side, at `offset` unknowns inside the
+// grid, `wrap` unknowns across a periodic boundary, or through the ghost value
+static inline void neighbour(bandMatrix *J, int r, int side, bool inside, int offset, int wrap, double weight){
+
+    if(inside) {
+        bandAdd(J, r, r + offset, weight);
+    } else if(grid.bc[side] == MOL_PERIODIC) {
+        bandAdd(J, r, r + wrap, weight);
+    } else {
+        bandAdd(J, r, r, weight * ghostSlope(side));
+    }
+}
+
+// Banded Jacobian of molDerivative() at (t, y), lower = upper as molBandwidth(): the
+// stencil entries are exact, the reaction blocks of the nodes are forward differences
+// of the reaction alone. Returns the reaction sweeps used, counted as derivative
+// evaluations.
+int molJacobian(const double *t, const double y[], bandMatrix *J){
+
+    int nx = grid.nx, ny = grid.ny, nc = grid.ncomp, row = nx * nc;
+    double x[2], u[nc], r0[nc], r[nc], delta;
+
+    bandZero(J);
+
+    // Block 1 Calculations: stencil
+    for (int node = 0; node < nx * ny; ++node) {
+        int i = node % nx, j = node / nx;
+        for (int c = 0; c < nc; ++c) {
+            int k = node * nc + c;
+            bandAdd(J, k, k, wC[c]);
+            neighbour(J, k, MOL_WEST, i > 0, -nc, (nx - 1) * nc, wW[c]);
+            neighbour(J, k, MOL_EAST, i < nx - 1, nc, -(nx - 1) * nc, wE[c]);
+            if(grid.dims == 2) {
+                neighbour(J, k, MOL_SOUTH, j > 0, -row, (ny - 1) * row, wS[c]);
+                neighbour(J, k, MOL_NORTH, j < ny - 1, row, -(ny - 1) * row, wN[c]);
+            }
+        }
+    }
+
+    if(reaction == NULL) {
+        return 0;
+    }
+
+    // Block 2 Calculations: reaction blocks, one column per component
+    for (int node = 0; node < nx * ny; ++node) {
+        molNode(node, x);
+        for (int c = 0; c < nc; ++c) {
+            u[c] = y[node * nc + c];
+        }
+        reaction(t, x, u, r0);
+
+        for (int col = 0; col < nc; ++col) {
+            delta = sqrt(UROUND * FMAX(1.0e-5, fabs(u[col])));
+            u[col] += delta;
+            reaction(t, x, u, r);
+            u[col] = y[node * nc + col];
+            for (int c = 0; c < nc; ++c) {
+                bandAdd(J, node * nc + c, node * nc + col, (r[c] - r0[c]) / delta);
+            }
+        }
+    }
+
+    return nc + 1;
+}
+
+// coupling across a periodic boundary that falls outside the band, added to the dense matrix
+static inline void corner(gsl_matrix *jac, int r, int side, bool inside, int wrap, double weight, int bandwidth){
+
+    if(inside == false && grid.bc[side] == MOL_PERIODIC && abs(wrap) > bandwidth) {
+        gsl_matrix_set(jac, r, r + wrap, gsl_matrix_get(jac, r, r + wrap) + weight);
+    }
+}
+
+// the banded Jacobian written into the dense matrix of the implicit methods, with the
+// corner entries of periodic boundaries that the band leaves out
+int molJacobianDense(const double *t, const double y[], gsl_matrix *jac){
+
+    int nx = grid.nx, ny = grid.ny, nc = grid.ncomp, row = nx * nc, lower, upper, calls;
+
+    molBandwidth(&lower, &upper);
+    bandMatrix *J = bandAlloc(molSize(), lower, upper);
+    calls = molJacobian(t, y, J);
+    bandToDense(J, jac);
+    bandFree(J);
+
+    for (int node = 0; node < nx * ny; ++node) {
+        int i = node % nx, j = node / nx;
+        for (int c = 0; c < nc; ++c) {
+            int k = node * nc + c;
+            corner(jac, k, MOL_WEST, i > 0, (nx - 1) * nc, wW[c], upper);
+            corner(jac, k, MOL_EAST, i < nx - 1, -(nx - 1) * nc, wE[c], lower);
+            if(grid.dims == 2) {
+                corner(jac, k, MOL_SOUTH, j > 0, (ny - 1) * row, wS[c], upper);
+                corner(jac, k, MOL_NORTH, j < ny - 1, -(ny - 1) * row, wN[c], lower);
+            }
+        }
+    }
+
+    return calls;
+}
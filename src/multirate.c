@@ -0,0 +1,230 @@
+/*
+* Multirate integration for models whose components split into a fast and a slow group:
+* the slow group takes the macro step of the Bogacki-Shampine 3(2) pair, the fast group
+* substeps across it with the slow components interpolated.
+*/
+
+#include "multirate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+#define FMIN(x, y) ( x < y ? x : y )
+
+// workspace of the macro step in progress, behind the fast subsystem derivative
+static multirateWork *activeRate = NULL;
+
+// derivative of the fast group registered by setMultirateModel(), NULL for the full one
+static void (*fastModel)(const double *t, const double y[], double ydot[]) = NULL;
+
+// ----------------------------------------------------------------------------
+//
+//                            Workspace
+//
+// ----------------------------------------------------------------------------
+
+multirateWork * multirateAlloc(int NSYS, const int fast[], int fastCount, int ratio){
+
+    multirateWork *work = (multirateWork *) malloc(sizeof(multirateWork));
+
+    work -> NSYS = NSYS;
+    work -> fastCount = fastCount;
+    work -> fast = (int *) malloc(sizeof(int) * fastCount);
+    memcpy(work -> fast, fast, sizeof(int) * fastCount);
+    work -> ratio = (ratio < 1) ? 1 : ratio;
+    work -> hFast = 0.0;
+    work -> tMacro = 0.0; work -> hMacro = 0.0;
+    work -> cont = (double *) malloc(sizeof(double) * 4 * NSYS);
+    work -> derivative = NULL;
+
+    return work;
+}
+
+void multirateFree(multirateWork *work){
+
+    if(work == NULL) {
+        return;
+    }
+
+    free(work -> fast);
+    free(work -> cont);
+    if(activeRate == work) {
+        activeRate = NULL;
+    }
+    free(work);
+}
+
+// Registers a derivative that needs to fill only the fast components of ydot, called
+// by the fast substeps instead of the full derivative: the saving of the multirate
+// method on the slow components.
+void setMultirateModel(void (*fFast)(const double *t, const double y[], double ydot[])){
+
+    fastModel = fFast;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Multirate Step
+//
+// ----------------------------------------------------------------------------
+
+// derivative of the fast group alone, the slow components from the macro interpolant
+static void fastDerivative(const double *t, const double yf[], double ff[]){
+
+    multirateWork *work = activeRate;
+    int NSYS = work -> NSYS;
+    double y[NSYS], f[NSYS];
+
+    polynomial_dense((*t - work -> tMacro) / work -> hMacro, work -> cont, 3, y, NSYS);
+    for (int k = 0; k < work -> fastCount; ++k) {
+        y[work -> fast[k]] = yf[k];
+    }
+
+    (fastModel != NULL) ? fastModel(t, y, f) : work -> derivative(t, y, f);
+
+    for (int k = 0; k < work -> fastCount; ++k) {
+        ff[k] = f[work -> fast[k]];
+    }
+}
+
+// The fast group across the macro step [t, t + H] in adaptive substeps of the
+// Bogacki-Shampine pair, starting from f(t, y) in dydt and the substep work -> hFast
+// of the last macro step; the last substep lands on t + H. Fills the fast components
+// of ytemp.
+static void fastSubsteps(multirateWork *work, const double *t, const double y[], double ytemp[], const double dydt[], double H, const errorNorm *norm, odeOptions *options){
+
+    static double safety = 0.9;
+    int nf = work -> fastCount;
+    double h = work -> hFast, tf = *t, t_end = *t + H, yf[nf], yfnew[nf], Kf[4 * nf], err;
+    double absWeight[nf], relWeight[nf];
+    errorNorm fastNorm = { .absWeight = absWeight, .relWeight = relWeight, .type = norm -> type };
+
+    for (int k = 0; k < nf; ++k) {
+        yf[k] = y[work -> fast[k]];
+        Kf[k] = dydt[work -> fast[k]];
+        absWeight[k] = norm -> absWeight[work -> fast[k]];
+        relWeight[k] = norm -> relWeight[work -> fast[k]];
+    }
+
+    while(tf < t_end) {
+
+        // land on the end of the macro step, without a sliver of a last substep
+        bool last = (tf + 1.1 * h >= t_end);
+        double step = last ? t_end - tf : h;
+
+        if(tf + step == tf) {
+            fprintf(stderr, "\nstepsize underflow in multirate algorithm..now exiting to system\n");
+            exit(1);
+        }
+
+        // a substep without a fast-only model evaluates the whole derivative
+        err = BogackiShampine32(fastDerivative, &tf, yf, yfnew, step, &fastNorm, Kf, nf);
+        if(fastModel != NULL) {
+            options -> stats.fastCalls += 3;
+        } else {
+            options -> stats.rhsCalls += 3;
+        }
+
+        if(err > 1.0) {
+            options -> stats.fastRejected += 1;
+            h = step * FMAX(safety * pow(err, -1.0 / 3.0), 0.25);
+            continue;
+        }
+        options -> stats.fastAccepted += 1;
+
+        // first same as last
+        tf = last ? t_end : tf + step;
+        for (int k = 0; k < nf; ++k) {
+            yf[k] = yfnew[k];
+            Kf[k] = Kf[3 * nf + k];
+        }
+
+        // the shortened last substep does not set the next one
+        if(last == false || step >= h) {
+            h = step * ((err > 0.0) ? FMIN(safety * pow(err, -1.0 / 3.0), 4.0) : 4.0);
+        }
+    }
+
+    for (int k = 0; k < nf; ++k) {
+        ytemp[work -> fast[k]] = yf[k];
+    }
+
+    work -> hFast = h;
+}
+
+// Method ID = 24
+// Multirate Bogacki-Shampine 3(2), slowest first: the whole system takes the macro step
+// H, whose error is measured on the slow components only; its cubic Hermite interpolant
+// then supplies the slow components while the fast group crosses the step in substeps
+// with their own error control. f(t, y) is supplied by the caller in stages[0]. Returns
+// the stepsize for the next macro step.
+double MultirateStep(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double ytemp[], double *h, const errorNorm *norm, odeOptions *options){
+
+    static double safety = 0.9;
+    multirateWork *work = options -> multirate;
+    int NSYS = options -> NSYS, slowCount = NSYS - work -> fastCount;
+    double *K = options -> stages, H = *h, errSlow, hnext;
+    double absWeight[NSYS], relWeight[NSYS];
+    errorNorm slowNorm = { .absWeight = absWeight, .relWeight = relWeight, .type = norm -> type };
+
+    // slow components only: the fast ones get an infinite weight
+    for (int var = 0; var < NSYS; ++var) {
+        absWeight[var] = norm -> absWeight[var];
+        relWeight[var] = norm -> relWeight[var];
+    }
+    for (int k = 0; k < work -> fastCount; ++k) {
+        absWeight[work -> fast[k]] = HUGE_VAL;
+        relWeight[work -> fast[k]] = 0.0;
+    }
+
+    // first substep from the ratio of the input file
+    if(work -> hFast == 0.0) {
+        work -> hFast = H / work -> ratio;
+    }
+
+    while(true) {
+
+        H = FMIN(H, options -> domain[1] - *t);
+
+        if(*t + H == *t) {
+            fprintf(stderr, "\nstepsize underflow in multirate algorithm..now exiting to system\n");
+            exit(1);
+        }
+
+        // Block 1 Calculations: macro step of the whole system, error of the slow group
+        errSlow = BogackiShampine32(derivative, t, y, ytemp, H, &slowNorm, K, NSYS);
+        options -> stats.rhsCalls += 3;
+        if(norm -> type == ERRORNORM_RMS && slowCount > 0) {
+            errSlow *= sqrt((double) NSYS / slowCount);
+        }
+
+        if(errSlow <= 1.0) {
+            break;
+        }
+
+        options -> stats.rejected += 1;
+        H *= FMAX(safety * pow(errSlow, -1.0 / 3.0), 0.25);
+    }
+
+    options -> stats.accepted += 1;
+
+    // Block 2 Calculations: fast substeps along the slow interpolant
+    work -> derivative = derivative;
+    work -> tMacro = *t; work -> hMacro = H;
+    Hermite_contd(y, ytemp, K, &K[3 * NSYS], H, work -> cont, NSYS);
+    activeRate = work;
+
+    fastSubsteps(work, t, y, ytemp, K, H, norm, options);
+
+    // next macro step from the slow error, grown by a maximum factor of 4
+    hnext = H * ((errSlow > 0.0) ? FMIN(safety * pow(errSlow, -1.0 / 3.0), 4.0) : 4.0);
+
+    *h = H;
+
+    return hnext;
+}
@@ -0,0 +1,148 @@
+/*
+* Forward sensitivities of the solution to parameters of the model: the state and its
+* derivatives by the parameters integrated as one system, the right hand side of the
+* sensitivities from directional derivatives of derivative().
+*/
+
+#include "sensitivity.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define UROUND 2.2e-16
+
+// parameters registered by setSensitivityParameters(), fields read by the model
+static double *parameters[SENS_MAXPARAMS];
+static const char *parameterNames[SENS_MAXPARAMS];
+static double parameterScale[SENS_MAXPARAMS]; // |p| at the start, 1 for a zero parameter
+static int parameterCount = 0;
+
+// right hand side of the state alone and its size
+static void (*model)(const double *t, const double y[], double ydot[]) = NULL;
+static int stateNSYS = 0;
+
+// ----------------------------------------------------------------------------
+//
+//                            Parameters
+//
+// ----------------------------------------------------------------------------
+
+// Registers the parameters for the sensitivities before callODESolver(): pointers to
+// the fields of the model's struct params that derivative() reads, and their names.
+// The sensitivities are computed when the input file sets "sensitivities".
+void setSensitivityParameters(double *fields[], const char *names[], int count){
+
+    if(count < 1 || count > SENS_MAXPARAMS) {
+        fprintf(stderr, "Sensitivities take 1 to %d parameters. Exiting program..\n", SENS_MAXPARAMS);
+        exit(EXIT_FAILURE);
+    }
+
+    for (int j = 0; j < count; ++j) {
+        parameters[j] = fields[j];
+        parameterNames[j] = names[j];
+    }
+    parameterCount = count;
+}
+
+int sensitivityCount(void){
+
+    return parameterCount;
+}
+
+// Extends the options read for the NSYS components of the state to the NSYS (1 + P)
+// of the state and its sensitivities: zero initial sensitivities, the relative
+// tolerance of the component and its absolute tolerance over |p_j|, as the scaling of
+// CVODES. Keeps derivative() as the model and returns the reallocated options.
+odeOptions * sensitivityInit(odeOptions *options, void (*derivative)(const double *t, const double y[], double ydot[])){
+
+    int NSYS = options -> NSYS, P = parameterCount, total = NSYS * (1 + P);
+
+    if(P == 0) {
+        fprintf(stderr, "Sensitivities need the parameters of the model, register them with setSensitivityParameters(). Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    options = (odeOptions *) realloc(options, sizeof(odeOptions) + sizeof(long double) * total);
+    options -> relTol = (double *) realloc(options -> relTol, sizeof(double) * total);
+    if(options -> absTol != NULL) {
+        options -> absTol = (double *) realloc(options -> absTol, sizeof(double) * total);
+    }
+
+    for (int j = 0; j < P; ++j) {
+        parameterScale[j] = (*parameters[j] != 0.0) ? fabs(*parameters[j]) : 1.0;
+        for (int var = 0; var < NSYS; ++var) {
+            int index = (j + 1) * NSYS + var;
+            options -> yInitCond[index] = 0.0;
+            options -> relTol[index] = options -> relTol[var];
+            if(options -> absTol != NULL) {
+                options -> absTol[index] = options -> absTol[var] / parameterScale[j];
+            }
+        }
+    }
+
+    model = derivative;
+    stateNSYS = NSYS;
+    options -> NSYS = total;
+
+    printf("\t- Sensitivities to");
+    for (int j = 0; j < P; ++j) {
+        printf(" %s (components %d to %d)%s", parameterNames[j], (j + 1) * NSYS, (j + 2) * NSYS - 1, (j < P - 1) ? "," : "\n");
+    }
+
+    return options;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Right Hand Side
+//
+// ----------------------------------------------------------------------------
+
+// Right hand side of the state and its sensitivities, in place of derivative(): f(t, y)
+// and for each parameter the directional derivative
+//     J s_j + df/dp_j = (f(t, y + sigma s_j; p + sigma e_j) - f(t, y; p)) / sigma,
+// one evaluation of the model per parameter, 1 + P per call. sigma = sqrt(uround) |p_j|
+// moves the parameter by a relative amount, cut so that sigma ||s_j|| stays below
+// sqrt(uround) (1 + ||y||) as the increment of Brown and Saad.
+void sensitivityDerivative(const double *t, const double Y[], double Ydot[]){
+
+    int NSYS = stateNSYS;
+    double yperturbed[NSYS], fperturbed[NSYS], ynorm = 0.0;
+
+    model(t, Y, Ydot);
+
+    for (int var = 0; var < NSYS; ++var) {
+        ynorm += Y[var] * Y[var];
+    }
+    ynorm = sqrt(ynorm / NSYS);
+
+    for (int j = 0; j < parameterCount; ++j) {
+
+        const double *s = &Y[(j + 1) * NSYS];
+        double *sdot = &Ydot[(j + 1) * NSYS], p = *parameters[j], snorm = 0.0, sigma;
+
+        for (int var = 0; var < NSYS; ++var) {
+            snorm += s[var] * s[var];
+        }
+        snorm = sqrt(snorm / NSYS);
+
+        sigma = sqrt(UROUND) * parameterScale[j];
+        if(snorm * sigma > sqrt(UROUND) * (1.0 + ynorm)) {
+            sigma = sqrt(UROUND) * (1.0 + ynorm) / snorm;
+        }
+
+        for (int var = 0; var < NSYS; ++var) {
+            yperturbed[var] = Y[var] + sigma * s[var];
+        }
+        *parameters[j] = p + sigma;
+        model(t, yperturbed, fperturbed);
+        *parameters[j] = p;
+
+        for (int var = 0; var < NSYS; ++var) {
+            sdot[var] = (fperturbed[var] - Ydot[var]) / sigma;
+        }
+    }
+}
@@ -0,0 +1,366 @@
+/*
+* Sparsity of the Jacobian: detection by perturbing the inputs of the right hand side,
+* colouring of the columns for compressed finite differences and the sidecar file
+* recording the pattern of a model.
+*/
+
+#include "sparsity.h"
+#include "stochastic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+// pattern used by the finite difference Jacobians, registered by setSparsity()
+static sparsityPattern *activePattern = NULL;
+
+// an output changed by the perturbation; NaN on both sides is no change
+static inline bool changed(double before, double after){
+
+    return before != after && !(isnan(before) && isnan(after));
+}
+
+static sparsityPattern * patternAlloc(int NSYS, int nonzeros){
+
+    sparsityPattern *pattern = (sparsityPattern *) malloc(sizeof(sparsityPattern));
+
+    pattern -> NSYS = NSYS;
+    pattern -> nonzeros = nonzeros;
+    pattern -> colStart = (int *) malloc(sizeof(int) * (NSYS + 1));
+    pattern -> rows = (int *) malloc(sizeof(int) * (nonzeros > 0 ? nonzeros : 1));
+    pattern -> colors = 0;
+    pattern -> colorStart = (int *) malloc(sizeof(int) * (NSYS + 1));
+    pattern -> columns = (int *) malloc(sizeof(int) * NSYS);
+    pattern -> lower = pattern -> upper = 0;
+
+    return pattern;
+}
+
+void sparsityFree(sparsityPattern *pattern){
+
+    if(pattern == NULL) {
+        return;
+    }
+
+    free(pattern -> colStart);
+    free(pattern -> rows);
+    free(pattern -> colorStart);
+    free(pattern -> columns);
+    free(pattern);
+}
+
+void setSparsity(sparsityPattern *pattern){
+
+    activePattern = pattern;
+}
+
+sparsityPattern * getSparsity(void){
+
+    return activePattern;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Detection
+//
+// ----------------------------------------------------------------------------
+
+// SPARSITY_PROBES base points drawn around y with relative spread 1e-2 and their
+// derivatives, one evaluation each. Random points keep entries that vanish at y itself,
+// such as the products with a zero initial value; the derivatives double as the
+// fingerprint of the model in the sidecar file.
+static void basePoints(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double y[], int NSYS, double *base, double *fbase){
+
+    uint32_t key[2] = {0x5eed5eedu, 0x0c01u}, bits[4];
+
+    for (int probe = 0; probe < SPARSITY_PROBES; ++probe) {
+        for (int var = 0; var < NSYS; ++var) {
+            uint32_t counter[4] = {(uint32_t) var, (uint32_t) probe, 0u, 0u};
+            philox4x32(counter, key, bits);
+            double uniform = 2.0 * (bits[0] + 0.5) / 4294967296.0 - 1.0;
+            base[probe * NSYS + var] = y[var] + 1.0e-2 * uniform * (fabs(y[var]) + 1.0e-2);
+        }
+        derivative(t, &base[probe * NSYS], &fbase[probe * NSYS]);
+    }
+}
+
+// Pattern of df/dy at the base points: each column is perturbed by 1e-3 of its size at
+// every base point and the outputs that change are its rows. Perturbations rather than
+// NaN propagation keep the dependencies hidden behind comparisons, fmax() and branches.
+// NSYS derivative evaluations per base point, counted in calls. The vectors are on the
+// heap: detection runs before the solver thread and its stack.
+static sparsityPattern * detect(void (*derivative)(const double *t, const double y[], double ydot[]), const double *t, const double *base, const double *fbase, int NSYS, int *calls){
+
+    double *yperturbed = (double *) malloc(sizeof(double) * NSYS), *fperturbed = (double *) malloc(sizeof(double) * NSYS);
+    int capacity = 4 * NSYS, nonzeros = 0, *rows = (int *) malloc(sizeof(int) * capacity);
+    bool *seen = (bool *) malloc(sizeof(bool) * NSYS);
+    sparsityPattern *pattern;
+
+    *calls = 0;
+
+    pattern = patternAlloc(NSYS, 0);
+    for (int col = 0; col < NSYS; ++col) {
+
+        pattern -> colStart[col] = nonzeros;
+        for (int row = 0; row < NSYS; ++row) {
+            seen[row] = false;
+        }
+
+        for (int probe = 0; probe < SPARSITY_PROBES; ++probe) {
+            const double *z = &base[probe * NSYS], *fz = &fbase[probe * NSYS];
+            for (int var = 0; var < NSYS; ++var) {
+                yperturbed[var] = z[var];
+            }
+            yperturbed[col] = z[col] + 1.0e-3 * (fabs(z[col]) + 1.0e-3);
+
+            derivative(t, yperturbed, fperturbed);
+
+            for (int row = 0; row < NSYS; ++row) {
+                seen[row] = seen[row] || changed(fz[row], fperturbed[row]);
+            }
+        }
+        *calls += SPARSITY_PROBES;
+
+        for (int row = 0; row < NSYS; ++row) {
+            if(seen[row] == false) {
+                continue;
+            }
+            if(nonzeros == capacity) {
+                capacity *= 2;
+                rows = (int *) realloc(rows, sizeof(int) * capacity);
+            }
+            rows[nonzeros++] = row;
+        }
+    }
+    pattern -> colStart[NSYS] = nonzeros;
+    pattern -> nonzeros = nonzeros;
+    free(pattern -> rows);
+    pattern -> rows = rows;
+
+    free(yperturbed);
+    free(fperturbed);
+    free(seen);
+
+    return pattern;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Colouring
+//
+// ----------------------------------------------------------------------------
+
+// sorts columns by decreasing count of nonzeros, ties by index
+static const int *sortStart = NULL;
+
+static int byNonzeros(const void *a, const void *b){
+
+    int i = *(const int *) a, j = *(const int *) b;
+    int ni = sortStart[i + 1] - sortStart[i], nj = sortStart[j + 1] - sortStart[j];
+
+    return (ni != nj) ? nj - ni : i - j;
+}
+
+// Greedy distance-2 colouring of the columns in the largest-first order of Welsh and
+// Powell: each column takes the smallest colour not held by a column sharing one of
+// its rows. Banded patterns come out with lower + upper + 1 colours, as the column
+// groups of Curtis, Powell and Reid. Also records the bandwidths of the pattern.
+static void colour(sparsityPattern *pattern){
+
+    int NSYS = pattern -> NSYS, nonzeros = pattern -> nonzeros;
+    int *rowStart = (int *) calloc(NSYS + 1, sizeof(int)), *cols = (int *) malloc(sizeof(int) * (nonzeros > 0 ? nonzeros : 1));
+    int *order = (int *) malloc(sizeof(int) * 5 * (NSYS + 1));
+    int *color = &order[NSYS + 1], *forbidden = &order[2 * (NSYS + 1)], *fill = &order[3 * (NSYS + 1)], *count = &order[4 * (NSYS + 1)];
+
+    // Block 1 Calculations: columns of each row, the transpose of the pattern
+    for (int k = 0; k < nonzeros; ++k) {
+        rowStart[pattern -> rows[k] + 1] += 1;
+    }
+    for (int row = 0; row < NSYS; ++row) {
+        rowStart[row + 1] += rowStart[row];
+        fill[row] = rowStart[row];
+    }
+    pattern -> lower = pattern -> upper = 0;
+    for (int col = 0; col < NSYS; ++col) {
+        for (int k = pattern -> colStart[col]; k < pattern -> colStart[col + 1]; ++k) {
+            int row = pattern -> rows[k];
+            cols[fill[row]++] = col;
+            pattern -> lower = (row - col > pattern -> lower) ? row - col : pattern -> lower;
+            pattern -> upper = (col - row > pattern -> upper) ? col - row : pattern -> upper;
+        }
+    }
+
+    // Block 2 Calculations: greedy colours, largest first
+    for (int col = 0; col < NSYS; ++col) {
+        order[col] = col;
+        color[col] = -1;
+        forbidden[col] = -1;
+    }
+    sortStart = pattern -> colStart;
+    qsort(order, NSYS, sizeof(int), byNonzeros);
+
+    pattern -> colors = 0;
+    for (int index = 0; index < NSYS; ++index) {
+        int col = order[index], c = 0;
+        for (int k = pattern -> colStart[col]; k < pattern -> colStart[col + 1]; ++k) {
+            int row = pattern -> rows[k];
+            for (int m = rowStart[row]; m < rowStart[row + 1]; ++m) {
+                if(color[cols[m]] >= 0) {
+                    forbidden[color[cols[m]]] = col;
+                }
+            }
+        }
+        while(forbidden[c] == col) {
+            c += 1;
+        }
+        color[col] = c;
+        pattern -> colors = (c + 1 > pattern -> colors) ? c + 1 : pattern -> colors;
+    }
+
+    // Block 3 Calculations: columns grouped by colour
+    for (int c = 0; c <= pattern -> colors; ++c) {
+        count[c] = 0;
+    }
+    for (int col = 0; col < NSYS; ++col) {
+        count[color[col] + 1] += 1;
+    }
+    for (int c = 0; c < pattern -> colors; ++c) {
+        count[c + 1] += count[c];
+        pattern -> colorStart[c] = count[c];
+    }
+    pattern -> colorStart[pattern -> colors] = NSYS;
+    for (int col = 0; col < NSYS; ++col) {
+        pattern -> columns[count[color[col]]++] = col;
+    }
+
+    free(rowStart);
+    free(cols);
+    free(order);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Sidecar File
+//
+// ----------------------------------------------------------------------------
+
+// pattern of NSYS unknowns from the sidecar file of an earlier run and the fingerprint it
+// was detected with, NULL if the file is missing, malformed or sized otherwise
+static sparsityPattern * readPattern(const char *path, int NSYS, double *fingerprint){
+
+    FILE *file = fopen(path, "r");
+    char line[256];
+    int size, nonzeros, count;
+
+    if(file == NULL) {
+        return NULL;
+    }
+
+    if(fgets(line, sizeof(line), file) == NULL || fscanf(file, "%d %d", &size, &nonzeros) != 2 || size != NSYS || nonzeros < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    for (int k = 0; k < SPARSITY_PROBES * NSYS; ++k) {
+        if(fscanf(file, "%lf", &fingerprint[k]) != 1) {
+            fclose(file);
+            return NULL;
+        }
+    }
+    sparsityPattern *pattern = patternAlloc(NSYS, nonzeros);
+    pattern -> colStart[0] = 0;
+    for (int col = 0; col < NSYS; ++col) {
+        bool valid = (fscanf(file, "%d", &count) == 1 && count >= 0 && pattern -> colStart[col] + count <= nonzeros);
+        for (int k = 0; valid && k < count; ++k) {
+            int *row = &pattern -> rows[pattern -> colStart[col] + k];
+            valid = (fscanf(file, "%d", row) == 1 && *row >= 0 && *row < NSYS);
+        }
+        if(valid == false) {
+            sparsityFree(pattern);
+            fclose(file);
+            return NULL;
+        }
+        pattern -> colStart[col + 1] = pattern -> colStart[col] + count;
+    }
+    fclose(file);
+
+    if(pattern -> colStart[NSYS] != nonzeros) {
+        sparsityFree(pattern);
+        return NULL;
+    }
+
+    return pattern;
+}
+
+static void writePattern(const char *path, const sparsityPattern *pattern, const double *fingerprint){
+
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL) {
+        printf("\t- Could not write the sparsity pattern to %s..\n", path);
+        return;
+    }
+
+    fprintf(file, "# sparsity pattern of df/dy: NSYS nonzeros, the derivatives at the base points, then each column as its count and rows\n");
+    fprintf(file, "%d %d\n", pattern -> NSYS, pattern -> nonzeros);
+    for (int k = 0; k < SPARSITY_PROBES * pattern -> NSYS; ++k) {
+        fprintf(file, "%.17g%c", fingerprint[k], (k % pattern -> NSYS == pattern -> NSYS - 1) ? '\n' : ' ');
+    }
+    for (int col = 0; col < pattern -> NSYS; ++col) {
+        fprintf(file, "%d", pattern -> colStart[col + 1] - pattern -> colStart[col]);
+        for (int k = pattern -> colStart[col]; k < pattern -> colStart[col + 1]; ++k) {
+            fprintf(file, " %d", pattern -> rows[k]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
+// Sparsity pattern of the model at the initial values, cached in
+// ./workspace/data/<model>/sparsity.txt with the derivatives at the base points as the
+// fingerprint of the model. A run recomputes only those SPARSITY_PROBES evaluations and
+// reuses the stored pattern when they match to the last bit; a changed model, initial
+// value or size detects the pattern again and rewrites the file.
+sparsityPattern * sparsityInit(void (*derivative)(const double *t, const double y[], double ydot[]), odeOptions *options){
+
+    char path[strlen(options -> model) + 64];
+    int NSYS = options -> NSYS, calls = 0;
+    double *base = (double *) malloc(sizeof(double) * SPARSITY_PROBES * NSYS);
+    double *fbase = (double *) malloc(sizeof(double) * SPARSITY_PROBES * NSYS);
+    double *fingerprint = (double *) malloc(sizeof(double) * SPARSITY_PROBES * NSYS);
+
+    sprintf(path, "./workspace/data/%s/sparsity.txt", options -> model);
+
+    basePoints(derivative, &options -> domain[0], options -> yInitCond, NSYS, base, fbase);
+    sparsityPattern *pattern = readPattern(path, NSYS, fingerprint);
+
+    for (int k = 0; pattern != NULL && k < SPARSITY_PROBES * NSYS; ++k) {
+        if(changed(fingerprint[k], fbase[k])) {
+            printf("\t- The model differs from the sparsity pattern in %s..\n", path);
+            sparsityFree(pattern);
+            pattern = NULL;
+        }
+    }
+
+    if(pattern != NULL) {
+        printf("\t- Sparsity pattern read from %s, fingerprint checked with %d derivative evaluations\n", path, SPARSITY_PROBES);
+    }
+    else {
+        pattern = detect(derivative, &options -> domain[0], base, fbase, NSYS, &calls);
+        printf("\t- Sparsity pattern detected with %d derivative evaluations, written to %s\n", SPARSITY_PROBES + calls, path);
+        writePattern(path, pattern, fbase);
+    }
+
+    free(base);
+    free(fbase);
+    free(fingerprint);
+
+    colour(pattern);
+
+    printf("\t- %d nonzeros, bandwidths %d and %d, Jacobians in %d derivative evaluations\n", pattern -> nonzeros, pattern -> lower, pattern -> upper, pattern -> colors);
+
+    return pattern;
+}
@@ -0,0 +1,149 @@
+/*
+* Operator splitting over a model composed of sub right hand sides: Lie (first order)
+* and Strang (second order) sequences of the operators, each advanced by its own fixed
+* stepsize method or by its exact flow.
+*/
+
+#include "splitting.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// operators registered by addSplitOperator() and addSplitFlow(), in order of application
+static splitOperator operators[SPLIT_MAXOPERATORS];
+static int operatorCount = 0;
+
+// fixed stepsize methods of algorithms.c by methodId
+static void (*const fixedMethods[])(void (*)(const double *, const double [], double []), double *, double [], double, int) = {
+    NULL, FWEuler, Heun, Midpoint, RK2Ralston, RK3Classic, RK3Optim, RK4, RK5Butcher
+};
+
+// ----------------------------------------------------------------------------
+//
+//                            Operators
+//
+// ----------------------------------------------------------------------------
+
+static splitOperator * newOperator(int every){
+
+    if(operatorCount == SPLIT_MAXOPERATORS) {
+        fprintf(stderr, "At most %d split operators. Exiting program..\n", SPLIT_MAXOPERATORS);
+        exit(EXIT_FAILURE);
+    }
+
+    splitOperator *op = &operators[operatorCount++];
+    *op = (splitOperator) { .derivative = NULL, .flow = NULL, .methodId = 0, .substeps = 1,
+                            .every = (every < 1) ? 1 : every, .pending = 0, .tStart = 0.0, .elapsed = 0.0 };
+    return op;
+}
+
+// Appends an operator advanced by `substeps` steps of the fixed stepsize method methodId
+// (1-8) per splitting step, run once every `every` splitting steps.
+void addSplitOperator(void (*derivative)(const double *t, const double y[], double ydot[]), int methodId, int substeps, int every){
+
+    if(methodId < 1 || methodId > 8) {
+        fprintf(stderr, "Split operators use the fixed stepsize methods 1-8. Exiting program..\n");
+        exit(EXIT_FAILURE);
+    }
+
+    splitOperator *op = newOperator(every);
+    op -> derivative = derivative;
+    op -> methodId = methodId;
+    op -> substeps = (substeps < 1) ? 1 : substeps;
+}
+
+// Appends an operator with an exact solution: flow(t, y, step) advances y from t to t + step.
+void addSplitFlow(void (*flow)(const double *t, double y[], double step), int every){
+
+    splitOperator *op = newOperator(every);
+    op -> flow = flow;
+}
+
+void clearSplitOperators(void){
+
+    operatorCount = 0;
+}
+
+int splitOperatorCount(void){
+
+    return operatorCount;
+}
+
+// forgets the time collected by the operators on a coarser schedule
+void splitReset(void){
+
+    for (int index = 0; index < operatorCount; ++index) {
+        operators[index].pending = 0;
+        operators[index].elapsed = 0.0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Splitting Step
+//
+// ----------------------------------------------------------------------------
+
+static void runOperator(const splitOperator *op, double t, double y[], double step, int NSYS){
+
+    if(op -> flow != NULL) {
+        op -> flow(&t, y, step);
+        return;
+    }
+
+    double h = step / op -> substeps;
+    for (int substep = 0; substep < op -> substeps; ++substep) {
+        fixedMethods[op -> methodId](op -> derivative, &t, y, h, NSYS);
+    }
+}
+
+// an operator on a coarser schedule collects the splitting steps and runs over all of
+// them at once, after the last one or at the end of the domain
+static void runScheduled(splitOperator *op, double t, double y[], double step, bool final, int NSYS){
+
+    if(op -> pending == 0) {
+        op -> tStart = t;
+    }
+    op -> pending += 1;
+    op -> elapsed += step;
+
+    if(op -> pending == op -> every || final) {
+        runOperator(op, op -> tStart, y, op -> elapsed, NSYS);
+        op -> pending = 0;
+        op -> elapsed = 0.0;
+    }
+}
+
+// Method ID = 25
+// One splitting step over [t, t + step]. Lie (splittingOrder 1) runs the operators in
+// turn over the whole step; Strang (splittingOrder 2) runs all but the last over half
+// the step, the last over the whole step, then the others in reverse over the second
+// half. Operators on a coarser schedule keep their place in the first sweep, which
+// makes them first order.
+void SplitStep(double *t, double y[], double step, odeOptions *options){
+
+    int NSYS = options -> NSYS, last = operatorCount - 1;
+    bool strang = (options -> splittingOrder == 2);
+    bool final = (*t + step >= options -> domain[1] - 1.0e-12 * fabs(step));
+    double half = strang ? 0.5 * step : step;
+
+    // Block 1 Calculations: forward sweep
+    for (int index = 0; index < operatorCount; ++index) {
+        splitOperator *op = &operators[index];
+        if(op -> every > 1) {
+            runScheduled(op, *t, y, step, final, NSYS);
+        } else {
+            runOperator(op, *t, y, (index == last) ? step : half, NSYS);
+        }
+    }
+
+    // Block 2 Calculations: backward sweep over the second half
+    for (int index = last - 1; strang && index >= 0; --index) {
+        if(operators[index].every == 1) {
+            runOperator(&operators[index], *t + half, y, half, NSYS);
+        }
+    }
+
+    *t += step;
+}
@@ -0,0 +1,572 @@
+/*
+* Stochastic differential equations dy = f(t, y) dt + g(t, y) dW with diagonal noise:
+* Euler-Maruyama, Milstein and the stochastic Runge-Kutta methods SRA1 and SRIW1 of
+* Roessler, on Brownian paths drawn from a counter-based generator, and Monte Carlo
+* ensembles of paths across threads.
+*/
+
+#include "stochastic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+
+// most threads of an ensemble
+#define SDE_MAXTHREADS 64
+
+// accepted steps below this error move a level up the Brownian tree, where the
+// error of order h^1.5 grows by 2^1.5
+#define SDE_COARSEN 0.3
+
+// diffusion registered by setDiffusion(), NULL for a deterministic model
+static void (*diffusion)(const double *t, const double y[], double g[]) = NULL;
+
+// ----------------------------------------------------------------------------
+//
+//                            Random Numbers
+//
+// ----------------------------------------------------------------------------
+
+// Ten rounds of Philox4x32 on counter under key: each round multiplies two words into
+// 64 bit products and mixes their halves with the other two words and the key, which
+// is bumped by the Weyl constants between rounds.
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]){
+
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = (uint64_t) 0xD2511F53u * c0, p1 = (uint64_t) 0xCD9E8D57u * c2;
+        uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0, n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t) p1; c3 = (uint32_t) p0;
+        c0 = n0; c2 = n2;
+        k0 += 0x9E3779B9u; k1 += 0xBB67AE85u;
+    }
+
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// four standard normals of a tree node for the component pair, by Box-Muller on
+// uniforms in the open unit interval
+static void nodeNormals(const brownianPath *path, largeInt node, int pair, double normal[4]){
+
+    uint32_t counter[4] = { (uint32_t) node, (uint32_t) (node >> 32), (uint32_t) path -> interval, (uint32_t) pair };
+    uint32_t key[2] = { path -> seed, path -> member }, bits[4];
+
+    philox4x32(counter, key, bits);
+
+    for (int k = 0; k < 4; k += 2) {
+        double u1 = ((double) bits[k] + 0.5) * 0x1p-32, u2 = ((double) bits[k + 1] + 0.5) * 0x1p-32;
+        double r = sqrt(-2.0 * log(u1));
+        normal[k] = r * cos(2.0 * M_PI * u2);
+        normal[k + 1] = r * sin(2.0 * M_PI * u2);
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Brownian Path
+//
+// ----------------------------------------------------------------------------
+
+void setDiffusion(void (*g)(const double *t, const double y[], double gout[])){
+
+    diffusion = g;
+}
+
+bool hasDiffusion(void){
+
+    return diffusion != NULL;
+}
+
+// true for a diffusion that does not depend on y, the additive noise of SRA1: g(t, y)
+// against g at two points moved from y by a tenth of each component and more, in
+// opposite directions for alternate components
+bool diffusionAdditive(double t, const double y[], int NSYS){
+
+    double g[NSYS], gprobe[NSYS], yprobe[NSYS];
+
+    diffusion(&t, y, g);
+
+    for (int probe = 0; probe < 2; ++probe) {
+        for (int var = 0; var < NSYS; ++var) {
+            double sign = ((var + probe) % 2 == 0) ? 1.0 : -1.0;
+            yprobe[var] = y[var] + sign * 0.1 * (fabs(y[var]) + 1.0);
+        }
+        diffusion(&t, yprobe, gprobe);
+        for (int var = 0; var < NSYS; ++var) {
+            if(gprobe[var] != g[var]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+brownianPath * brownianAlloc(int NSYS, uint32_t seed){
+
+    brownianPath *path = (brownianPath *) malloc(sizeof(brownianPath));
+
+    path -> NSYS = NSYS;
+    path -> seed = seed;
+    path -> member = 0;
+    path -> interval = 0;
+    path -> length = 0.0;
+    path -> depth = -1;
+    path -> W = (double *) malloc(sizeof(double) * (SDE_MAXDEPTH + 1) * NSYS);
+    path -> H = (double *) malloc(sizeof(double) * (SDE_MAXDEPTH + 1) * NSYS);
+
+    return path;
+}
+
+void brownianFree(brownianPath *path){
+
+    if(path == NULL) {
+        return;
+    }
+
+    free(path -> W);
+    free(path -> H);
+    free(path);
+}
+
+// Starts the path of ensemble member over output interval index interval, drawing the
+// root: W ~ N(0, h) and H ~ N(0, h / 12), independent.
+void brownianReset(brownianPath *path, uint32_t member, largeInt interval, double length){
+
+    int NSYS = path -> NSYS;
+    double normal[4];
+
+    path -> member = member;
+    path -> interval = interval;
+    path -> length = length;
+    path -> depth = 0;
+    path -> node[0] = 1;
+
+    for (int var = 0; var < NSYS; ++var) {
+        if(var % 2 == 0) {
+            nodeNormals(path, 0, var / 2, normal);
+        }
+        path -> W[var] = sqrt(length) * normal[2 * (var % 2)];
+        path -> H[var] = sqrt(length / 12.0) * normal[2 * (var % 2) + 1];
+    }
+}
+
+// Splits the cached node at depth into the child `right`. Given (W, H) of a parent of
+// length 2 tau, the halves satisfy W = W1 + W2 and H = (H1 + H2) / 2 + (W1 - W2) / 4;
+// with d = W1 - W2 = 3 H + sqrt(tau / 2) xi1 and e = H1 - H2 = sqrt(tau / 6) xi2 they
+// are again independent with W_i ~ N(0, tau) and H_i ~ N(0, tau / 12).
+static void brownianSplit(brownianPath *path, int depth, int right){
+
+    int NSYS = path -> NSYS;
+    largeInt node = path -> node[depth];
+    double tau = 0.5 * ldexp(path -> length, -depth), normal[4];
+    const double *W = &path -> W[depth * NSYS], *H = &path -> H[depth * NSYS];
+    double *Wc = &path -> W[(depth + 1) * NSYS], *Hc = &path -> H[(depth + 1) * NSYS];
+
+    for (int var = 0; var < NSYS; ++var) {
+        if(var % 2 == 0) {
+            nodeNormals(path, node, var / 2, normal);
+        }
+        double d = 3.0 * H[var] + sqrt(0.5 * tau) * normal[2 * (var % 2)];
+        double e = sqrt(tau / 6.0) * normal[2 * (var % 2) + 1];
+        double m = H[var] - 0.25 * d;
+        Wc[var] = right ? 0.5 * (W[var] - d) : 0.5 * (W[var] + d);
+        Hc[var] = right ? m - 0.5 * e : m + 0.5 * e;
+    }
+
+    path -> node[depth + 1] = 2 * node + right;
+}
+
+// Increments dW and dZ (the integral of W - W(t) over the step) of step index of the
+// output interval cut into 2^level steps. Descends from the deepest cached node on the
+// way, so a sweep over the steps costs about two splits per step.
+void brownianIncrement(brownianPath *path, int level, largeInt index, double dW[], double dZ[]){
+
+    int NSYS = path -> NSYS, depth = (path -> depth < level) ? path -> depth : level;
+    largeInt target = ((largeInt) 1 << level) + index;
+    double h = ldexp(path -> length, -level);
+
+    while(path -> node[depth] != (target >> (level - depth))) {
+        depth -= 1;
+    }
+
+    if(depth < level) {
+        for (; depth < level; ++depth) {
+            brownianSplit(path, depth, (int) ((target >> (level - depth - 1)) & 1));
+        }
+        path -> depth = level;
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        dW[var] = path -> W[level * NSYS + var];
+        dZ[var] = h * (path -> H[level * NSYS + var] + 0.5 * dW[var]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Stochastic Steppers
+//
+// ----------------------------------------------------------------------------
+
+// norm of the error estimate err, weighted as the adaptive steppers of ODESolvers.c do:
+// absTol + relTol * max(|y|, |ynew|), or relTol * (|y| + |h f| + |g| sqrt(h)) without absTol
+static double sdeError(const double y[], const double ynew[], const double err[], const double f[], const double g[], double h, const odeOptions *options){
+
+    static double nonZeroScaffold = 1.0e-30;
+    double sumSquares = 0.0, maxRatio = 0.0;
+
+    for (int var = 0; var < options -> NSYS; ++var) {
+        double weight = (options -> absTol != NULL)
+                      ? options -> absTol[var] + options -> relTol[var] * FMAX(fabs(y[var]), fabs(ynew[var]))
+                      : options -> relTol[var] * (fabs(y[var]) + fabs(h * f[var]) + fabs(g[var]) * sqrt(h) + nonZeroScaffold);
+        double ratio = fabs(err[var]) / weight;
+        sumSquares += ratio * ratio;
+        maxRatio = FMAX(maxRatio, ratio);
+    }
+
+    return (options -> normType == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / options -> NSYS);
+}
+
+// Method ID = 26
+// Euler-Maruyama, strong order 0.5
+static void EulerMaruyama(void (*derivative)(const double *t, const double y[], double ydot[]), double t, const double y[], double ynew[], double h, const double dW[], odeStats *stats, int NSYS){
+
+    double f[NSYS], g[NSYS];
+
+    derivative(&t, y, f);
+    diffusion(&t, y, g);
+    stats -> rhsCalls += 1; stats -> diffusionCalls += 1;
+
+    for (int var = 0; var < NSYS; ++var) {
+        ynew[var] = y[var] + f[var] * h + g[var] * dW[var];
+    }
+}
+
+// Method ID = 27
+// Milstein for diagonal noise, strong order 1: g g' from the difference of g at the
+// support value y + f h + g sqrt(h), no derivative of the diffusion needed
+static void Milstein(void (*derivative)(const double *t, const double y[], double ydot[]), double t, const double y[], double ynew[], double h, const double dW[], odeStats *stats, int NSYS){
+
+    double f[NSYS], g[NSYS], gbar[NSYS], ybar[NSYS], sqrth = sqrt(h);
+
+    derivative(&t, y, f);
+    diffusion(&t, y, g);
+
+    for (int var = 0; var < NSYS; ++var) {
+        ybar[var] = y[var] + f[var] * h + g[var] * sqrth;
+    }
+
+    diffusion(&t, ybar, gbar);
+    stats -> rhsCalls += 1; stats -> diffusionCalls += 2;
+
+    for (int var = 0; var < NSYS; ++var) {
+        ynew[var] = y[var] + f[var] * h + g[var] * dW[var] + (gbar[var] - g[var]) * (dW[var] * dW[var] - h) / (2.0 * sqrth);
+    }
+}
+
+// Method ID = 28
+// SRA1 of Roessler for additive noise g(t), strong order 1.5 with dZ, two stages.
+// Returns the norm of its difference to Euler-Maruyama.
+static double SRA1(void (*derivative)(const double *t, const double y[], double ydot[]), double t, const double y[], double ynew[], double h, const double dW[], const double dZ[], const odeOptions *options, odeStats *stats){
+
+    int NSYS = options -> NSYS;
+    double f0[NSYS], f1[NSYS], g0[NSYS], g1[NSYS], H0[NSYS], err[NSYS];
+    double t1 = t + 0.75 * h, tEnd = t + h;
+
+    // Block 1 Calculations
+    derivative(&t, y, f0);
+    diffusion(&t, y, g0);
+    diffusion(&tEnd, y, g1);
+
+    for (int var = 0; var < NSYS; ++var) {
+        H0[var] = y[var] + 0.75 * f0[var] * h + 1.5 * g1[var] * dZ[var] / h;
+    }
+
+    // Block 2 Calculations
+    derivative(&t1, H0, f1);
+    stats -> rhsCalls += 2; stats -> diffusionCalls += 2;
+
+    for (int var = 0; var < NSYS; ++var) {
+        ynew[var] = y[var] + (f0[var] + 2.0 * f1[var]) * h / 3.0 + g1[var] * (dW[var] - dZ[var] / h) + g0[var] * dZ[var] / h;
+        err[var] = ynew[var] - (y[var] + f0[var] * h + g0[var] * dW[var]);
+    }
+
+    return sdeError(y, ynew, err, f0, g0, h, options);
+}
+
+// Method ID = 29
+// SRIW1 of Roessler for diagonal Ito noise, strong order 1.5 with the iterated integrals
+// I11, I111 and I10 = dZ, two drift and four diffusion stages. Its third diffusion stage
+// is the support value of the derivative-free Milstein step (with the opposite sign),
+// which gives the error estimate for free.
+static double SRIW1(void (*derivative)(const double *t, const double y[], double ydot[]), double t, const double y[], double ynew[], double h, const double dW[], const double dZ[], const odeOptions *options, odeStats *stats){
+
+    int NSYS = options -> NSYS;
+    double f1[NSYS], f2[NSYS], g1[NSYS], g2[NSYS], g3[NSYS], g4[NSYS], H0[NSYS], H1[NSYS], err[NSYS];
+    double sqrth = sqrt(h), tQuarter = t + 0.25 * h, t3Quarter = t + 0.75 * h, tEnd = t + h;
+
+    // Block 1 Calculations
+    derivative(&t, y, f1);
+    diffusion(&t, y, g1);
+
+    for (int var = 0; var < NSYS; ++var) {
+        H0[var] = y[var] + 0.75 * f1[var] * h + 1.5 * g1[var] * dZ[var] / h;
+        H1[var] = y[var] + 0.25 * f1[var] * h + 0.5 * g1[var] * sqrth;
+    }
+
+    // Block 2 Calculations
+    derivative(&t3Quarter, H0, f2);
+    diffusion(&tQuarter, H1, g2);
+
+    for (int var = 0; var < NSYS; ++var) {
+        H1[var] = y[var] + f1[var] * h - g1[var] * sqrth;
+    }
+
+    // Block 3 Calculations
+    diffusion(&tEnd, H1, g3);
+
+    for (int var = 0; var < NSYS; ++var) {
+        H1[var] = y[var] + 0.25 * f1[var] * h + (-5.0 * g1[var] + 3.0 * g2[var] + 0.5 * g3[var]) * sqrth;
+    }
+
+    // Block 4 Calculations
+    diffusion(&tQuarter, H1, g4);
+    stats -> rhsCalls += 2; stats -> diffusionCalls += 4;
+
+    for (int var = 0; var < NSYS; ++var) {
+        double I1 = dW[var], I11 = 0.5 * (dW[var] * dW[var] - h), I111 = (dW[var] * dW[var] - 3.0 * h) * dW[var] / 6.0, I10 = dZ[var];
+        double b1 = I1, b2 = I11 / sqrth, b3 = I10 / h, b4 = I111 / h;
+
+        ynew[var] = y[var] + (f1[var] + 2.0 * f2[var]) * h / 3.0
+                  + (-b1 - b2 + 2.0 * b3 - 2.0 * b4) * g1[var]
+                  + (4.0 * b1 + 4.0 * b2 - 4.0 * b3 + 5.0 * b4) / 3.0 * g2[var]
+                  + (2.0 * b1 - b2 - 2.0 * b3 - 2.0 * b4) / 3.0 * g3[var]
+                  + b4 * g4[var];
+        err[var] = ynew[var] - (y[var] + f1[var] * h + g1[var] * I1 + (g1[var] - g3[var]) * I11 / sqrth);
+    }
+
+    return sdeError(y, ynew, err, f1, g1, h, options);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Output Interval
+//
+// ----------------------------------------------------------------------------
+
+// Crosses the output interval [t, t + length] of the path in steps length / 2^level.
+// SRA1 and SRIW1 with stepsize control step down the Brownian tree on a rejected step
+// and back up after a small error at an even step, so every step is a node of the same
+// path; the level reached is kept for the next interval. Reads options only and counts
+// into stats, so ensemble threads share the options.
+static void sdeInterval(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double length, int *level, brownianPath *path, const odeOptions *options, odeStats *stats){
+
+    int NSYS = options -> NSYS, lev = *level;
+    bool control = options -> sdeAdaptive && options -> methodId >= 28;
+    double tStart = *t, ynew[NSYS], dW[NSYS], dZ[NSYS], err = 0.0;
+    largeInt index = 0;
+
+    while(index < ((largeInt) 1 << lev)) {
+
+        double h = ldexp(length, -lev), tStep = tStart + index * h;
+
+        brownianIncrement(path, lev, index, dW, dZ);
+
+        switch(options -> methodId) {
+            case 26: EulerMaruyama(derivative, tStep, y, ynew, h, dW, stats, NSYS); break;
+            case 27: Milstein(derivative, tStep, y, ynew, h, dW, stats, NSYS); break;
+            case 28: err = SRA1(derivative, tStep, y, ynew, h, dW, dZ, options, stats); break;
+            case 29: err = SRIW1(derivative, tStep, y, ynew, h, dW, dZ, options, stats); break;
+        }
+
+        if(control && err > 1.0) {
+            if(lev == SDE_MAXDEPTH) {
+                fprintf(stderr, "\nstepsize underflow in stochastic algorithm..now exiting to system\n");
+                exit(1);
+            }
+            stats -> rejected += 1;
+            lev += 1;
+            index *= 2;
+            continue;
+        }
+
+        stats -> accepted += 1;
+        for (int var = 0; var < NSYS; ++var) {
+            y[var] = ynew[var];
+        }
+        index += 1;
+
+        if(control && err < SDE_COARSEN && lev > 0 && index % 2 == 0) {
+            lev -= 1;
+            index /= 2;
+        }
+    }
+
+    *t = tStart + length;
+    *level = lev;
+}
+
+// One output interval [t, t + step] of the path of member 0.
+void SDEStep(void (*derivative)(const double *t, const double y[], double ydot[]), double *t, double y[], double step, odeOptions *options){
+
+    largeInt interval = (largeInt) ((*t - options -> domain[0]) / options -> outInterval + 0.5);
+
+    brownianReset(options -> brownian, 0, interval, step);
+    sdeInterval(derivative, t, y, step, &options -> sdeLevel, options -> brownian, options, &options -> stats);
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Ensembles
+//
+// ----------------------------------------------------------------------------
+
+// members first to last - 1 of an ensemble, with their sums on the output grid
+typedef struct _sdeWork {
+    void (*derivative)(const double *t, const double y[], double ydot[]);
+    const odeOptions *options;
+    const double *grid;
+    largeInt points;
+    int first, last;
+    double *sum, *sumSquares; // points * NSYS
+    odeStats stats;
+} sdeWork;
+
+static void * sdeWorker(void *arg){
+
+    sdeWork *work = (sdeWork *) arg;
+    const odeOptions *options = work -> options;
+    int NSYS = options -> NSYS;
+    brownianPath *path = brownianAlloc(NSYS, options -> seed);
+    double y[NSYS], t;
+
+    for (int member = work -> first; member < work -> last; ++member) {
+
+        int level = options -> sdeLevel;
+        for (int var = 0; var < NSYS; ++var) {
+            y[var] = options -> yInitCond[var];
+        }
+
+        for (largeInt point = 1; point < work -> points; ++point) {
+            t = work -> grid[point - 1];
+            brownianReset(path, member, point - 1, work -> grid[point] - t);
+            sdeInterval(work -> derivative, &t, y, work -> grid[point] - t, &level, path, options, &work -> stats);
+
+            for (int var = 0; var < NSYS; ++var) {
+                work -> sum[point * NSYS + var] += y[var];
+                work -> sumSquares[point * NSYS + var] += y[var] * y[var];
+            }
+        }
+    }
+
+    brownianFree(path);
+
+    return NULL;
+}
+
+// Monte Carlo ensemble of ensembleSize paths, members 0, 1, ... of the seed, on the
+// output grid. The members are cut into contiguous blocks, one per thread, each with its
+// own sums; a member draws the same path on any number of threads. The mean goes into
+// result, and the standard deviation at the end of the domain is printed. Returns the
+// index of the last grid point, as the loop of ODESolver() leaves it.
+largeInt sdeEnsemble(void (*derivative)(const double *t, const double y[], double ydot[]), solution *result, odeOptions *options){
+
+    int NSYS = options -> NSYS, members = options -> ensembleSize;
+    int threads = (options -> threads < 1) ? 1 : options -> threads;
+    largeInt point;
+
+    threads = (threads > members) ? members : threads;
+    threads = (threads > SDE_MAXTHREADS) ? SDE_MAXTHREADS : threads;
+
+    // output grid of the fixed stepsize runs
+    for (point = 0; gsl_vector_get(result -> dom, point) < options -> domain[1]; ++point) {
+        if(point + 1 == options -> GRIDPOINTS) {
+            realloc_gsl_containers(result, options);
+        }
+        double endtime = gsl_vector_get(result -> dom, point) + options -> outInterval;
+        gsl_vector_set(result -> dom, point + 1, (endtime > options -> domain[1]) ? options -> domain[1] : endtime);
+    }
+
+    largeInt points = point + 1;
+    double *grid = (double *) malloc(sizeof(double) * points);
+    for (largeInt k = 0; k < points; ++k) {
+        grid[k] = gsl_vector_get(result -> dom, k);
+    }
+
+    printf("\t- Ensemble of %d paths on %d threads\n", members, threads);
+
+    sdeWork work[SDE_MAXTHREADS];
+    pthread_t thread[SDE_MAXTHREADS];
+
+    for (int i = 0; i < threads; ++i) {
+        work[i] = (sdeWork) { .derivative = derivative, .options = options, .grid = grid, .points = points,
+                              .first = (int) ((long long) members * i / threads), .last = (int) ((long long) members * (i + 1) / threads),
+                              .sum = (double *) calloc(points * NSYS, sizeof(double)),
+                              .sumSquares = (double *) calloc(points * NSYS, sizeof(double)), .stats = {0} };
+    }
+
+    // the calling thread takes the first block
+    bool joined[SDE_MAXTHREADS] = { false };
+    for (int i = 1; i < threads; ++i) {
+        if(pthread_create(&thread[i], NULL, sdeWorker, &work[i]) != 0) {
+            sdeWorker(&work[i]);
+        } else {
+            joined[i] = true;
+        }
+    }
+
+    sdeWorker(&work[0]);
+
+    for (int i = 1; i < threads; ++i) {
+        if(joined[i]) {
+            pthread_join(thread[i], NULL);
+        }
+    }
+
+    // Block 1 Calculations: sums of the blocks in member order, mean into result
+    for (int i = 1; i < threads; ++i) {
+        for (largeInt k = NSYS; k < points * NSYS; ++k) {
+            work[0].sum[k] += work[i].sum[k];
+            work[0].sumSquares[k] += work[i].sumSquares[k];
+        }
+        work[0].stats.accepted += work[i].stats.accepted;
+        work[0].stats.rejected += work[i].stats.rejected;
+        work[0].stats.rhsCalls += work[i].stats.rhsCalls;
+        work[0].stats.diffusionCalls += work[i].stats.diffusionCalls;
+    }
+
+    for (largeInt k = 1; k < points; ++k) {
+        for (int var = 0; var < NSYS; ++var) {
+            gsl_matrix_set(result -> func, var, k, work[0].sum[k * NSYS + var] / members);
+        }
+    }
+
+    printf("\t- Standard deviation at t = %g:", grid[points - 1]);
+    for (int var = 0; var < NSYS; ++var) {
+        double mean = work[0].sum[(points - 1) * NSYS + var] / members;
+        double variance = (members > 1) ? (work[0].sumSquares[(points - 1) * NSYS + var] - members * mean * mean) / (members - 1) : 0.0;
+        printf(" %g", sqrt(FMAX(variance, 0.0)));
+    }
+    printf("\n\n");
+
+    options -> stats.accepted += work[0].stats.accepted;
+    options -> stats.rejected += work[0].stats.rejected;
+    options -> stats.rhsCalls += work[0].stats.rhsCalls;
+    options -> stats.diffusionCalls += work[0].stats.diffusionCalls;
+
+    for (int i = 0; i < threads; ++i) {
+        free(work[i].sum);
+        free(work[i].sumSquares);
+    }
+    free(grid);
+
+    return point;
+}
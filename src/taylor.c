@@ -0,0 +1,732 @@
+/*
+* Taylor series integrator: the right hand side is recorded as a tape of elementary
+* operations whose Taylor coefficients follow from the usual recurrences (Taylor mode
+* automatic differentiation), so a step of any order costs one sweep per coefficient.
+*/
+
+#include "taylor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+// -- Macro/Inline Functions ---------------------------------------------------------
+
+#define FMAX(x, y) ( x > y ? x : y )
+#define FMIN(x, y) ( x < y ? x : y )
+
+// k-th Taylor coefficient of node n
+#define COEF(tape, n, k) ((tape) -> coef[(n) * (TAYLOR_MAXORDER + 1) + (k)])
+
+// model registered by setTaylorModel(), also behind taylorDerivative()
+static taylorTape *activeModel = NULL;
+
+// ----------------------------------------------------------------------------
+//
+//                            Tape Construction
+//
+// ----------------------------------------------------------------------------
+
+taylorTape * taylorTapeAlloc(int NSYS){
+
+    taylorTape *tape = (taylorTape *) malloc(sizeof(taylorTape));
+
+    tape -> NSYS = NSYS;
+    tape -> nodeCount = 0;
+    tape -> capacity = 0;
+    tape -> nodes = NULL;
+    tape -> coef = NULL;
+    tape -> tangent = NULL;
+    tape -> tangentSize = 0;
+    tape -> output = (int *) malloc(sizeof(int) * NSYS);
+
+    // nodes 0 .. NSYS - 1 are the components of y, node NSYS is t
+    for (int var = 0; var < NSYS; ++var) {
+        tape -> output[var] = -1;
+        taylorVariable(tape, var);
+    }
+    taylorTime(tape);
+
+    return tape;
+}
+
+void taylorTapeFree(taylorTape *tape){
+
+    if(tape == NULL) {
+        return;
+    }
+
+    free(tape -> nodes);
+    free(tape -> coef);
+    free(tape -> tangent);
+    free(tape -> output);
+    free(tape);
+}
+
+// appends a node, or returns an identical one already on the tape
+static int addNode(taylorTape *tape, enum taylorOp op, int a, int b, double value){
+
+    for (int node = 0; node < tape -> nodeCount; ++node) {
+        taylorNode *old = &tape -> nodes[node];
+        if(old -> op == op && old -> a == a && old -> b == b && old -> value == value) {
+            return node;
+        }
+    }
+
+    if(tape -> nodeCount == tape -> capacity) {
+        tape -> capacity = (tape -> capacity == 0) ? 32 : 2 * tape -> capacity;
+        tape -> nodes = (taylorNode *) realloc(tape -> nodes, sizeof(taylorNode) * tape -> capacity);
+        tape -> coef = (double *) realloc(tape -> coef, sizeof(double) * tape -> capacity * (TAYLOR_MAXORDER + 1));
+    }
+
+    tape -> nodes[tape -> nodeCount] = (taylorNode) { .op = op, .a = a, .b = b, .value = value };
+
+    return tape -> nodeCount++;
+}
+
+int taylorConstant(taylorTape *tape, double value){
+
+    return addNode(tape, TAYLOR_CONST, -1, -1, value);
+}
+
+int taylorVariable(taylorTape *tape, int var){
+
+    return addNode(tape, TAYLOR_VAR, -1, -1, var);
+}
+
+int taylorTime(taylorTape *tape){
+
+    return addNode(tape, TAYLOR_TIME, -1, -1, 0.0);
+}
+
+static inline bool isConstant(const taylorTape *tape, int node){
+
+    return tape -> nodes[node].op == TAYLOR_CONST;
+}
+
+// a + b, a - b, a * b and a / b, folded when both are constants
+int taylorBinary(taylorTape *tape, enum taylorOp op, int a, int b){
+
+    if(isConstant(tape, a) && isConstant(tape, b)) {
+        double u = tape -> nodes[a].value, v = tape -> nodes[b].value;
+        switch(op) {
+            case TAYLOR_ADD: return taylorConstant(tape, u + v);
+            case TAYLOR_SUB: return taylorConstant(tape, u - v);
+            case TAYLOR_MUL: return taylorConstant(tape, u * v);
+            case TAYLOR_DIV: return taylorConstant(tape, u / v);
+            default: break;
+        }
+    }
+
+    return addNode(tape, op, a, b, 0.0);
+}
+
+// -a and the elementary functions; sin and cos are recorded together as their
+// recurrences need each other
+int taylorUnary(taylorTape *tape, enum taylorOp op, int a){
+
+    if(isConstant(tape, a)) {
+        double u = tape -> nodes[a].value;
+        switch(op) {
+            case TAYLOR_NEG: return taylorConstant(tape, -u);
+            case TAYLOR_EXP: return taylorConstant(tape, exp(u));
+            case TAYLOR_LOG: return taylorConstant(tape, log(u));
+            case TAYLOR_SQRT: return taylorConstant(tape, sqrt(u));
+            case TAYLOR_SIN: return taylorConstant(tape, sin(u));
+            case TAYLOR_COS: return taylorConstant(tape, cos(u));
+            default: break;
+        }
+    }
+
+    if(op == TAYLOR_SIN || op == TAYLOR_COS) {
+        for (int node = 0; node < tape -> nodeCount; ++node) {
+            if(tape -> nodes[node].op == op && tape -> nodes[node].a == a) {
+                return node;
+            }
+        }
+        int sine = addNode(tape, TAYLOR_SIN, a, tape -> nodeCount + 1, 0.0);
+        int cosine = addNode(tape, TAYLOR_COS, a, sine, 0.0);
+        return (op == TAYLOR_SIN) ? sine : cosine;
+    }
+
+    return addNode(tape, op, a, -1, 0.0);
+}
+
+// a^p: small integer powers by repeated multiplication (exact at a = 0), others by the
+// power recurrence, which needs a != 0
+int taylorPower(taylorTape *tape, int a, double p){
+
+    if(isConstant(tape, a)) {
+        return taylorConstant(tape, pow(tape -> nodes[a].value, p));
+    }
+
+    if(p == floor(p) && fabs(p) <= 16.0) {
+        int n = (int) fabs(p), result = taylorConstant(tape, 1.0), square = a;
+        for (; n > 0; n /= 2) {
+            if(n % 2 == 1) {
+                result = (isConstant(tape, result)) ? square : taylorBinary(tape, TAYLOR_MUL, result, square);
+            }
+            if(n > 1) {
+                square = taylorBinary(tape, TAYLOR_MUL, square, square);
+            }
+        }
+        return (p < 0.0) ? taylorBinary(tape, TAYLOR_DIV, taylorConstant(tape, 1.0), result) : result;
+    }
+
+    return addNode(tape, TAYLOR_POW, a, -1, p);
+}
+
+void taylorOutput(taylorTape *tape, int var, int node){
+
+    tape -> output[var] = node;
+}
+
+void setTaylorModel(taylorTape *tape){
+
+    activeModel = tape;
+}
+
+taylorTape * getTaylorModel(void){
+
+    return activeModel;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Expression Parser
+//
+// ----------------------------------------------------------------------------
+
+// Recursive descent over one right hand side:
+//     expr    = term {('+' | '-') term}
+//     term    = unary {('*' | '/') unary}
+//     unary   = ('-' | '+') unary | power
+//     power   = primary ['^' unary]
+//     primary = number | 't' | 'y'index | 'y['index']' | 'pi' | constant | function '(' expr ')' | '(' expr ')'
+// with the functions exp, log, sqrt, sin and cos.
+
+typedef struct _taylorParser {
+    taylorTape *tape;
+    const char *text, *pos;
+    const char **names;
+    const double *values;
+    int constantCount;
+} taylorParser;
+
+static int parseExpr(taylorParser *);
+
+static void parseError(const taylorParser *parser, const char *message){
+
+    fprintf(stderr, "taylorModel: %s at position %d of \"%s\". Exiting program..\n", message, (int) (parser -> pos - parser -> text), parser -> text);
+    exit(EXIT_FAILURE);
+}
+
+static void skipSpaces(taylorParser *parser){
+
+    while(isspace((unsigned char) *parser -> pos)) {
+        parser -> pos++;
+    }
+}
+
+static bool accept(taylorParser *parser, char symbol){
+
+    skipSpaces(parser);
+    if(*parser -> pos == symbol) {
+        parser -> pos++;
+        return true;
+    }
+    return false;
+}
+
+static int parseIndex(taylorParser *parser){
+
+    char *end;
+    long index = strtol(parser -> pos, &end, 10);
+
+    if(end == parser -> pos || index < 0 || index >= parser -> tape -> NSYS) {
+        parseError(parser, "component index out of range");
+    }
+    parser -> pos = end;
+
+    return (int) index;
+}
+
+static int parsePrimary(taylorParser *parser){
+
+    skipSpaces(parser);
+    const char *start = parser -> pos;
+
+    if(accept(parser, '(')) {
+        int node = parseExpr(parser);
+        if(!accept(parser, ')')) {
+            parseError(parser, "missing ')'");
+        }
+        return node;
+    }
+
+    if(isdigit((unsigned char) *start) || *start == '.') {
+        char *end;
+        double value = strtod(start, &end);
+        parser -> pos = end;
+        return taylorConstant(parser -> tape, value);
+    }
+
+    if(!isalpha((unsigned char) *start) && *start != '_') {
+        parseError(parser, "expected a number, name or '('");
+    }
+
+    while(isalnum((unsigned char) *parser -> pos) || *parser -> pos == '_') {
+        parser -> pos++;
+    }
+    size_t length = parser -> pos - start;
+
+    // y0, y1, ... and y[0], y[1], ...
+    if(*start == 'y' && (length > 1 || (skipSpaces(parser), *parser -> pos == '['))) {
+        if(length == 1) {
+            accept(parser, '[');
+            int var = parseIndex(parser);
+            if(!accept(parser, ']')) {
+                parseError(parser, "missing ']'");
+            }
+            return taylorVariable(parser -> tape, var);
+        }
+        bool digits = true;
+        for (size_t index = 1; index < length; ++index) {
+            digits = digits && isdigit((unsigned char) start[index]);
+        }
+        if(digits) {
+            const char *end = parser -> pos;
+            parser -> pos = start + 1;
+            int var = parseIndex(parser);
+            parser -> pos = end;
+            return taylorVariable(parser -> tape, var);
+        }
+    }
+
+    if(length == 1 && *start == 't') {
+        return taylorTime(parser -> tape);
+    }
+    if(length == 2 && strncmp(start, "pi", 2) == 0) {
+        return taylorConstant(parser -> tape, M_PI);
+    }
+
+    for (int index = 0; index < parser -> constantCount; ++index) {
+        if(strlen(parser -> names[index]) == length && strncmp(start, parser -> names[index], length) == 0) {
+            return taylorConstant(parser -> tape, parser -> values[index]);
+        }
+    }
+
+    static const struct { const char *name; enum taylorOp op; } functions[] = {
+        {"exp", TAYLOR_EXP}, {"log", TAYLOR_LOG}, {"sqrt", TAYLOR_SQRT}, {"sin", TAYLOR_SIN}, {"cos", TAYLOR_COS}
+    };
+
+    for (size_t index = 0; index < sizeof(functions) / sizeof(functions[0]); ++index) {
+        if(strlen(functions[index].name) == length && strncmp(start, functions[index].name, length) == 0) {
+            if(!accept(parser, '(')) {
+                parseError(parser, "missing '(' after function name");
+            }
+            int argument = parseExpr(parser);
+            if(!accept(parser, ')')) {
+                parseError(parser, "missing ')'");
+            }
+            return taylorUnary(parser -> tape, functions[index].op, argument);
+        }
+    }
+
+    parser -> pos = start;
+    parseError(parser, "unknown name");
+
+    return -1;
+}
+
+static int parseUnary(taylorParser *parser);
+
+static int parsePower(taylorParser *parser){
+
+    int base = parsePrimary(parser);
+
+    if(accept(parser, '^')) {
+        int exponent = parseUnary(parser);
+        if(isConstant(parser -> tape, exponent)) {
+            return taylorPower(parser -> tape, base, parser -> tape -> nodes[exponent].value);
+        }
+        // a^b = exp(b log(a))
+        int logBase = taylorUnary(parser -> tape, TAYLOR_LOG, base);
+        return taylorUnary(parser -> tape, TAYLOR_EXP, taylorBinary(parser -> tape, TAYLOR_MUL, exponent, logBase));
+    }
+
+    return base;
+}
+
+static int parseUnary(taylorParser *parser){
+
+    if(accept(parser, '-')) {
+        return taylorUnary(parser -> tape, TAYLOR_NEG, parseUnary(parser));
+    }
+    if(accept(parser, '+')) {
+        return parseUnary(parser);
+    }
+
+    return parsePower(parser);
+}
+
+static int parseTerm(taylorParser *parser){
+
+    int node = parseUnary(parser);
+
+    while(true) {
+        if(accept(parser, '*')) {
+            node = taylorBinary(parser -> tape, TAYLOR_MUL, node, parseUnary(parser));
+        } else if(accept(parser, '/')) {
+            node = taylorBinary(parser -> tape, TAYLOR_DIV, node, parseUnary(parser));
+        } else {
+            return node;
+        }
+    }
+}
+
+static int parseExpr(taylorParser *parser){
+
+    int node = parseTerm(parser);
+
+    while(true) {
+        if(accept(parser, '+')) {
+            node = taylorBinary(parser -> tape, TAYLOR_ADD, node, parseTerm(parser));
+        } else if(accept(parser, '-')) {
+            node = taylorBinary(parser -> tape, TAYLOR_SUB, node, parseTerm(parser));
+        } else {
+            return node;
+        }
+    }
+}
+
+// Records the right hand sides expressions[0 .. NSYS - 1] on one tape, so common
+// subexpressions are evaluated once. names[] and values[] are the named constants.
+taylorTape * taylorParse(const char *expressions[], int NSYS, const char *names[], const double values[], int constantCount){
+
+    taylorTape *tape = taylorTapeAlloc(NSYS);
+    taylorParser parser = { .tape = tape, .names = names, .values = values, .constantCount = constantCount };
+
+    for (int var = 0; var < NSYS; ++var) {
+        parser.text = parser.pos = expressions[var];
+        int node = parseExpr(&parser);
+        skipSpaces(&parser);
+        if(*parser.pos != '\0') {
+            parseError(&parser, "unexpected character");
+        }
+        taylorOutput(tape, var, node);
+    }
+
+    return tape;
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Evaluation
+//
+// ----------------------------------------------------------------------------
+
+// k-th coefficient of node n from the coefficients 0 .. k of its operands and
+// 0 .. k - 1 of itself
+static inline double nodeCoefficient(const taylorTape *tape, int n, int k, double t){
+
+    const taylorNode *node = &tape -> nodes[n];
+    int a = node -> a, b = node -> b;
+    double sum = 0.0;
+
+    switch(node -> op) {
+        case TAYLOR_CONST: return (k == 0) ? node -> value : 0.0;
+        case TAYLOR_TIME: return (k == 0) ? t : ((k == 1) ? 1.0 : 0.0);
+        case TAYLOR_VAR: return COEF(tape, n, k); // set by the integration of the previous order
+        case TAYLOR_ADD: return COEF(tape, a, k) + COEF(tape, b, k);
+        case TAYLOR_SUB: return COEF(tape, a, k) - COEF(tape, b, k);
+        case TAYLOR_NEG: return -COEF(tape, a, k);
+        case TAYLOR_MUL:
+            for (int j = 0; j <= k; ++j) {
+                sum += COEF(tape, a, j) * COEF(tape, b, k - j);
+            }
+            return sum;
+        case TAYLOR_DIV:
+            for (int j = 0; j < k; ++j) {
+                sum += COEF(tape, n, j) * COEF(tape, b, k - j);
+            }
+            return (COEF(tape, a, k) - sum) / COEF(tape, b, 0);
+        case TAYLOR_EXP:
+            if(k == 0) {
+                return exp(COEF(tape, a, 0));
+            }
+            for (int j = 1; j <= k; ++j) {
+                sum += j * COEF(tape, a, j) * COEF(tape, n, k - j);
+            }
+            return sum / k;
+        case TAYLOR_LOG:
+            if(k == 0) {
+                return log(COEF(tape, a, 0));
+            }
+            for (int j = 1; j < k; ++j) {
+                sum += j * COEF(tape, n, j) * COEF(tape, a, k - j);
+            }
+            return (COEF(tape, a, k) - sum / k) / COEF(tape, a, 0);
+        case TAYLOR_SQRT:
+            if(k == 0) {
+                return sqrt(COEF(tape, a, 0));
+            }
+            for (int j = 1; j < k; ++j) {
+                sum += COEF(tape, n, j) * COEF(tape, n, k - j);
+            }
+            return (COEF(tape, a, k) - sum) / (2.0 * COEF(tape, n, 0));
+        case TAYLOR_POW:
+            if(k == 0) {
+                return pow(COEF(tape, a, 0), node -> value);
+            }
+            for (int j = 0; j < k; ++j) {
+                sum += (node -> value * (k - j) - j) * COEF(tape, a, k - j) * COEF(tape, n, j);
+            }
+            return sum / (k * COEF(tape, a, 0));
+        case TAYLOR_SIN:
+            if(k == 0) {
+                return sin(COEF(tape, a, 0));
+            }
+            for (int j = 1; j <= k; ++j) {
+                sum += j * COEF(tape, a, j) * COEF(tape, b, k - j);
+            }
+            return sum / k;
+        case TAYLOR_COS:
+            if(k == 0) {
+                return cos(COEF(tape, a, 0));
+            }
+            for (int j = 1; j <= k; ++j) {
+                sum += j * COEF(tape, a, j) * COEF(tape, b, k - j);
+            }
+            return -sum / k;
+    }
+
+    return 0.0;
+}
+
+// Taylor coefficients of the solution through (t, y) up to the given order:
+// series[k * NSYS + i] = (d^k y[i] / dt^k) / k!, from y[k + 1] = f[k] / (k + 1).
+void taylorCoefficients(taylorTape *tape, double t, const double y[], int order, double series[]){
+
+    int NSYS = tape -> NSYS;
+
+    for (int var = 0; var < NSYS; ++var) {
+        COEF(tape, var, 0) = series[var] = y[var];
+    }
+
+    for (int k = 0; k < order; ++k) {
+
+        for (int n = NSYS; n < tape -> nodeCount; ++n) {
+            COEF(tape, n, k) = nodeCoefficient(tape, n, k, t);
+        }
+
+        for (int var = 0; var < NSYS; ++var) {
+            COEF(tape, var, k + 1) = series[(k + 1) * NSYS + var] = COEF(tape, tape -> output[var], k) / (k + 1);
+        }
+    }
+}
+
+// f(t, y) from the zeroth coefficients of the tape
+static void tapeDerivative(taylorTape *tape, const double *t, const double y[], double ydot[]){
+
+    for (int var = 0; var < tape -> NSYS; ++var) {
+        COEF(tape, var, 0) = y[var];
+    }
+
+    for (int n = tape -> NSYS; n < tape -> nodeCount; ++n) {
+        COEF(tape, n, 0) = nodeCoefficient(tape, n, 0, *t);
+    }
+
+    for (int var = 0; var < tape -> NSYS; ++var) {
+        ydot[var] = COEF(tape, tape -> output[var], 0);
+    }
+}
+
+// f(t, y) of the registered model, the derivative function of the other methods
+// when the model comes from the input file
+void taylorDerivative(const double *t, const double y[], double ydot[]){
+
+    tapeDerivative(activeModel, t, y, ydot);
+}
+
+// Forward mode on the tape, the dual numbers of the first order: every node carries its
+// value and `width` tangents, seeded with dy/ds = seed (NSYS x width, row-major) and
+// dt/ds = 0. Each node applies its chain rule d n = ca d a + cb d b to all tangents in
+// one loop, so a sweep costs about 2 + width operations per node; nodes that do not
+// depend on y, such as functions of t alone, keep zero tangents. Leaves
+// ydot = f(t, y) and dydot[i * width + w] = df_i/dy seed_w, the Jacobian itself for the
+// identity seed, its product with v for width 1.
+void taylorTangents(taylorTape *tape, double t, const double y[], const double seed[], int width, double ydot[], double dydot[]){
+
+    int NSYS = tape -> NSYS;
+    bool active[tape -> nodeCount];
+
+    if(tape -> tangentSize < (long) tape -> nodeCount * width) {
+        tape -> tangentSize = (long) tape -> nodeCount * width;
+        tape -> tangent = (double *) realloc(tape -> tangent, sizeof(double) * tape -> tangentSize);
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        COEF(tape, var, 0) = y[var];
+        active[var] = true;
+        for (int w = 0; w < width; ++w) {
+            tape -> tangent[(long) var * width + w] = seed[(long) var * width + w];
+        }
+    }
+
+    for (int n = NSYS; n < tape -> nodeCount; ++n) {
+
+        const taylorNode *node = &tape -> nodes[n];
+        double value = COEF(tape, n, 0) = nodeCoefficient(tape, n, 0, t);
+        double a0 = (node -> a >= 0) ? COEF(tape, node -> a, 0) : 0.0, b0 = (node -> b >= 0) ? COEF(tape, node -> b, 0) : 0.0;
+        double ca = 0.0, cb = 0.0;
+
+        // partial derivatives by the operands
+        switch(node -> op) {
+            case TAYLOR_ADD: ca = 1.0; cb = 1.0; break;
+            case TAYLOR_SUB: ca = 1.0; cb = -1.0; break;
+            case TAYLOR_NEG: ca = -1.0; break;
+            case TAYLOR_MUL: ca = b0; cb = a0; break;
+            case TAYLOR_DIV: ca = 1.0 / b0; cb = -value / b0; break;
+            case TAYLOR_EXP: ca = value; break;
+            case TAYLOR_LOG: ca = 1.0 / a0; break;
+            case TAYLOR_SQRT: ca = 0.5 / value; break;
+            case TAYLOR_POW: ca = node -> value * pow(a0, node -> value - 1.0); break;
+            case TAYLOR_SIN: ca = cos(a0); break; // the cosine partner follows on the tape
+            case TAYLOR_COS: ca = -b0; break;
+            default: break; // constants and t
+        }
+
+        double *restrict dn = &tape -> tangent[(long) n * width];
+        const double *da = (node -> a >= 0) ? &tape -> tangent[(long) node -> a * width] : NULL;
+        const double *db = (node -> b >= 0) ? &tape -> tangent[(long) node -> b * width] : NULL;
+        active[n] = (node -> a >= 0 && active[node -> a]) || (node -> b >= 0 && node -> op != TAYLOR_SIN && node -> op != TAYLOR_COS && active[node -> b]);
+
+        if(active[n] == false) {
+            for (int w = 0; w < width; ++w) {
+                dn[w] = 0.0;
+            }
+        } else if(cb != 0.0) {
+            for (int w = 0; w < width; ++w) {
+                dn[w] = ca * da[w] + cb * db[w];
+            }
+        } else {
+            for (int w = 0; w < width; ++w) {
+                dn[w] = ca * da[w];
+            }
+        }
+    }
+
+    for (int var = 0; var < NSYS; ++var) {
+        ydot[var] = COEF(tape, tape -> output[var], 0);
+        for (int w = 0; w < width; ++w) {
+            dydot[(long) var * width + w] = tape -> tangent[(long) tape -> output[var] * width + w];
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+//
+//                            Taylor Integrator
+//
+// ----------------------------------------------------------------------------
+
+// One step of the Taylor method of order options -> order, with the stepsize of Jorba
+// and Zou (2005): the last two coefficients, weighted by the tolerances, are driven to
+// the error target, h = min(|y_k|^(-1/k), k = p - 1, p) * exp(-0.7 / (p - 1)). The
+// coefficients only see the solution at t, so the step is checked against the right
+// hand side at t + h/2 and t + h: the defect h |f(t', p(t')) - p'(t')| is about p + 1
+// times the local error, and a step whose defect exceeds that is retried 4 times shorter
+// at most. The scaled coefficients y_k h^k are left in options -> cont as the dense
+// output and f(t + h, ytemp) in stages[1]. *h enters as the trial stepsize and leaves
+// as the step taken, which is returned.
+double TaylorStep(double *t, double y[], double ytemp[], double *h, const errorNorm *norm, odeOptions *options){
+
+    static double safety = 0.9;
+    int NSYS = options -> NSYS, p = options -> order;
+    double *cont = options -> cont, *dydt = &options -> stages[options -> fsalSlot * NSYS];
+    double series[(p + 1) * NSYS], ymid[NSYS], slope[NSYS], fmid[NSYS];
+    double radius = HUGE_VAL, weight, sumSquares, maxRatio, ratio, coefNorm, hnew, scale, defect, tcheck;
+
+    taylorCoefficients(options -> taylor, *t, y, p, series);
+    options -> stats.rhsCalls += p; // one sweep of the tape per coefficient
+
+    // radius of convergence estimated from the last two coefficients
+    for (int k = p - 1; k <= p; ++k) {
+        sumSquares = 0.0; maxRatio = 0.0;
+        for (int var = 0; var < NSYS; ++var) {
+            weight = norm -> absWeight[var] + norm -> relWeight[var] * fabs(y[var]);
+            ratio = series[k * NSYS + var] / weight;
+            sumSquares += ratio * ratio;
+            maxRatio = FMAX(maxRatio, fabs(ratio));
+        }
+        coefNorm = (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+        if(coefNorm > 0.0) {
+            radius = FMIN(radius, pow(coefNorm, -1.0 / k));
+        }
+    }
+
+    // grow by a maximum factor of 4 as the other steppers; no radius for a polynomial solution
+    hnew = (radius < HUGE_VAL) ? radius * exp(-0.7 / (p - 1)) : HUGE_VAL;
+    hnew = FMIN(hnew, 4.0 * fabs(*h));
+
+    while(true) {
+
+        hnew = FMIN(hnew, options -> domain[1] - *t);
+
+        if(*t + hnew == *t) {
+            fprintf(stderr, "\nstepsize underflow in Taylor algorithm..now exiting to system\n");
+            exit(1);
+        }
+
+        // dense output in theta = (t' - t) / h
+        scale = 1.0;
+        for (int k = 0; k <= p; ++k) {
+            for (int var = 0; var < NSYS; ++var) {
+                cont[k * NSYS + var] = series[k * NSYS + var] * scale;
+            }
+            scale *= hnew;
+        }
+
+        // defect at the midpoint and at the end of the step
+        defect = 0.0;
+        for (int check = 1; check <= 2; ++check) {
+
+            double theta = 0.5 * check, *ycheck = (check == 1) ? ymid : ytemp, *fcheck = (check == 1) ? fmid : dydt;
+
+            tcheck = *t + theta * hnew;
+            polynomial_dense(theta, cont, p, ycheck, NSYS);
+            tapeDerivative(options -> taylor, &tcheck, ycheck, fcheck);
+            options -> stats.rhsCalls += 1;
+
+            sumSquares = 0.0; maxRatio = 0.0;
+            for (int var = 0; var < NSYS; ++var) {
+                slope[var] = 0.0;
+                for (int k = p; k >= 1; --k) {
+                    slope[var] = slope[var] * theta + k * cont[k * NSYS + var];
+                }
+                weight = norm -> absWeight[var] + norm -> relWeight[var] * FMAX(fabs(y[var]), fabs(ycheck[var]));
+                ratio = (hnew * fcheck[var] - slope[var]) / ((p + 1) * weight);
+                sumSquares += ratio * ratio;
+                maxRatio = FMAX(maxRatio, fabs(ratio));
+            }
+            coefNorm = (norm -> type == ERRORNORM_MAX) ? maxRatio : sqrt(sumSquares / NSYS);
+            defect = FMAX(defect, coefNorm);
+        }
+
+        if(defect <= 1.0) {
+            break;
+        }
+
+        options -> stats.rejected += 1;
+        hnew *= FMAX(safety * pow(defect, -1.0 / (p + 1)), 0.25);
+    }
+
+    options -> stats.accepted += 1;
+
+    *h = hnew;
+
+    return hnew;
+}
@@ -1,4 +1,12 @@
 #include "ODESolvers.h"
+#include "algorithms.h"
+#include "implicit.h"
+#include "taylor.h"
+#include "exponential.h"
+#include "multirate.h"
+#include "delay.h"
+#include "stochastic.h"
+#include "sparsity.h"
 #include "gnuplot_i.h"
 #include "utilities.h"
 #include <stdio.h>
@@ -16,8 +24,65 @@ void specifySolverMethodInit(odeOptions *options){
         case 6: options -> method = "RK3Optim"; break;
         case 7: options -> method = "RK4Classic"; break;
         case 8: options -> method = "RK5Butcher"; break;
+        case 9: options -> method = "CashKarpRKF45"; break;
+        case 10: options -> method = "Verner65"; break;
+        case 11: options -> method = "DOP853"; break;
+        case 12: options -> method = "BogackiShampine32"; break;
+        case 13: options -> method = "Fehlberg45"; break;
+        case 14: options -> method = "BulirschStoer"; break;
+        case 15: options -> method = "RKC"; break;
+        case 16: options -> method = "RadauIIA5"; break;
+        case 17: options -> method = "TRBDF2"; break;
+        case 18: options -> method = "ESDIRK43"; break;
+        case 19: options -> method = "Taylor"; break;
+        case 20: options -> method = "ETDRK4"; break;
+        case 21: options -> method = "ExpRosenbrock43"; break;
+        case 22: options -> method = "LinearExpm"; break;
+        case 23: options -> method = "ARK43"; break;
+        case 24: options -> method = "Multirate"; break;
+        case 25: options -> method = "Splitting"; break;
+        case 26: options -> method = "EulerMaruyama"; break;
+        case 27: options -> method = "Milstein"; break;
+        case 28: options -> method = "SRA1"; break;
+        case 29: options -> method = "SRIW1"; break;
+        case 30: options -> method = "ROS34PW2"; break;
         default: printf("Incorrect methodId declared. Exiting program..\n"); exit(EXIT_FAILURE);
     }
+
+    // order of the error estimate and stage layout of the adaptive steppers
+    // methods 1 and 3-8 run with Richardson step doubling: three steps per trial
+    static int order[] = {0, 1, 2, 2, 2, 3, 3, 4, 5}, stages[] = {0, 1, 2, 2, 2, 3, 3, 4, 6};
+
+    options -> firstStageShared = true; options -> fsal = false; options -> denseStageCount = 0;
+
+    switch(options -> methodId) {
+        case 2: options -> order = 1; options -> stageCount = 2; options -> fsalSlot = 1; break;
+        case 9: options -> order = 4; options -> stageCount = 6; options -> fsalSlot = 6; break;
+        case 10: options -> order = 5; options -> stageCount = 8; options -> fsalSlot = 8; break;
+        case 11: options -> order = 7; options -> stageCount = 12; options -> fsalSlot = 12; options -> denseStageCount = 3; break;
+        case 12: options -> order = 2; options -> stageCount = 4; options -> fsalSlot = 3; options -> fsal = true; break;
+        case 13: options -> order = 4; options -> stageCount = 6; options -> fsalSlot = 6; break;
+        case 14: options -> stageCount = 0; options -> fsalSlot = GBS_MAXROWS + 1; break; // order set by the extrapolation
+        case 15: options -> order = 2; options -> stageCount = 0; options -> fsalSlot = 1; options -> fsal = true; break; // stages set per step
+        case 16: options -> order = 5; options -> stageCount = 0; options -> fsalSlot = 1; options -> fsal = true; break; // Newton iterations vary
+        case 17: options -> order = 2; options -> stageCount = 1; options -> fsalSlot = 2; options -> fsal = true; break; // Newton iterations vary
+        case 18: options -> order = 3; options -> stageCount = 1; options -> fsalSlot = 5; options -> fsal = true; break; // Newton iterations vary
+        case 19: options -> stageCount = 0; options -> fsalSlot = 1; options -> fsal = true; break; // order set from the tolerance
+        case 20: options -> order = 4; options -> stageCount = 3 * 4; options -> firstStageShared = false; options -> fsalSlot = 1; break; // Richardson step doubling
+        case 21: options -> order = 3; options -> stageCount = 6; options -> fsalSlot = 1; options -> fsal = true; break; // Jacobian counted by the stepper, f(t + h) and the defect checks
+        case 22: options -> order = 0; options -> stageCount = 0; options -> fsalSlot = 1; break; // exact, output grid only
+        case 23: options -> order = 3; options -> stageCount = 1; options -> fsalSlot = 13; break; // Newton iterations vary
+        case 24: options -> order = 2; options -> stageCount = 0; options -> fsalSlot = 4; break; // substeps vary
+        case 25: options -> order = 2; options -> stageCount = 0; options -> fsalSlot = 1; break; // fixed stepsize only
+        case 26: case 27: case 28: case 29: options -> order = 1; options -> stageCount = 0; options -> fsalSlot = 1; break; // steps within the output intervals
+        case 30: options -> order = 2; options -> stageCount = 4; options -> fsalSlot = 1; break; // Jacobian counted by the stepper
+        default:
+            options -> order = order[options -> methodId];
+            options -> stageCount = 3 * stages[options -> methodId];
+            options -> firstStageShared = false;
+            options -> fsalSlot = 1;
+            break;
+    }
 }
 
 // -- Clear Memory -----------------------------------------------------------
@@ -32,6 +97,28 @@ void delete(solution *result, odeOptions *options){
 
     free(options -> model);
     free(options -> outputFilePath);
+    free(options -> relTol);
+    free(options -> absTol);
+    free(options -> yCurrent);
+    free(options -> stages);
+    free(options -> cont);
+    free(options -> spectralVector);
+    radauFree(options -> radau);
+    esdirkFree(options -> esdirk);
+    rosenbrockFree(options -> rosenbrock);
+    sparsityFree(options -> sparsity);
+    setSparsity(NULL);
+    free(options -> linearOperator);
+    free(options -> linearForcing);
+    free(options -> massMatrix);
+    expFree(options -> exponential);
+    free(options -> fastComponents);
+    multirateFree(options -> multirate);
+    free(options -> delays);
+    ddeFree(options -> delay);
+    brownianFree(options -> brownian);
+    taylorTapeFree(options -> taylor);
+    setTaylorModel(NULL);
     free(options);
 
     printf(" MEMORY DEALLOCATION COMPLETE ------\n");
@@ -89,6 +176,34 @@ void printResult(solution *result, odeOptions *options){
     }
 }
 
+void printStats(odeOptions *options){
+
+    if(options -> adaptive == 1) {
+        printf("\n\t- Adaptive steps: %llu accepted, %llu rejected\n", options -> stats.accepted, options -> stats.rejected);
+        printf("\t- Derivative evaluations: %llu, %llu saved by reusing the first stage\n", options -> stats.rhsCalls, options -> stats.rhsSaved);
+        if(options -> stats.fastAccepted > 0) {
+            printf("\t- Fast substeps: %llu accepted, %llu rejected\n", options -> stats.fastAccepted, options -> stats.fastRejected);
+        }
+        if(options -> stats.fastCalls > 0) {
+            printf("\t- Fast group evaluations: %llu\n", options -> stats.fastCalls);
+        }
+        if(options -> stats.jacobians > 0) {
+            printf("\t- Jacobians: %llu, LU decompositions: %llu\n", options -> stats.jacobians, options -> stats.decompositions);
+        }
+        if(options -> stats.refinements > 0) {
+            printf("\t- Mixed precision refinements: %llu\n", options -> stats.refinements);
+        }
+        if(options -> stats.krylovIterations > 0) {
+            printf("\t- Krylov iterations: %llu, preconditioner setups: %llu\n", options -> stats.krylovIterations, options -> stats.preconditionerSetups);
+        }
+    }
+
+    if(options -> stats.diffusionCalls > 0) {
+        printf("\n\t- Stochastic steps: %llu accepted, %llu rejected\n", options -> stats.accepted, options -> stats.rejected);
+        printf("\t- Drift evaluations: %llu, diffusion evaluations: %llu\n", options -> stats.rhsCalls, options -> stats.diffusionCalls);
+    }
+}
+
 void plotData(solution *result, odeOptions *options){
 
     if(options -> plotTimeSeries == 1) {
@@ -7,6 +7,7 @@
 
 #include "derivatives.h"
 #include "utilities.h"
+#include "sensitivity.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -22,6 +23,7 @@
 //  4) derivative() - interface function
 //  5) derivative_internal() - actual derivative with parameters
 //  6) events() - events function
+//  7) set_sensitivities() - parameters for the sensitivities, if any
 //
 // ----------------------------------------------------------------------------
 
@@ -52,6 +54,13 @@ void set_parameters(struct params *constptr){
     constptr -> k1 = g_consts.k3 = 50; // N/m
 }
 
+void set_sensitivities(void){
+
+    double *fields[] = {&g_consts.k1, &g_consts.k2, &g_consts.k3};
+    const char *names[] = {"k1", "k2", "k3"};
+    setSensitivityParameters(fields, names, 3);
+}
+
 void derivative(const double *t, const double y[], double ydot[]){
 
     derivative_internal(t, y, ydot, g_consts);
@@ -103,6 +112,13 @@ void set_parameters(struct params *constptr){
     constptr -> Vm = K * constptr -> Vt;
 }
 
+void set_sensitivities(void){
+
+    double *fields[] = {&g_consts.Vm, &g_consts.del};
+    const char *names[] = {"Vm", "del"};
+    setSensitivityParameters(fields, names, 2);
+}
+
 void derivative(const double *t, const double y[], double ydot[]){
 
     derivative_internal(t, y, ydot, g_consts);
@@ -162,6 +178,13 @@ void set_parameters(struct params *constptr){
     constptr -> k = 0.6;
 }
 
+void set_sensitivities(void){
+
+    double *fields[] = {&g_consts.k, &g_consts.mu, &g_consts.sig};
+    const char *names[] = {"k", "mu", "sig"};
+    setSensitivityParameters(fields, names, 3);
+}
+
 
 void derivative(const double *t, const double y[], double ydot[]){
 
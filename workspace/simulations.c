@@ -25,6 +25,7 @@ int main(int argc, char const *argv[]){
 void singleODE(void){
 
     set_parameters(&g_consts);
+    set_sensitivities();
     callODESolver(derivative, events, gConfig, g_NSYS);
 
 }
@@ -32,6 +33,7 @@ void singleODE(void){
 void systemODE(void){
 
     set_parameters(&g_consts);
+    set_sensitivities();
     callODESolver(derivative, events, gConfig, g_NSYS);
 
 }